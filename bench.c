@@ -0,0 +1,376 @@
+/*****************************************************************************
+ * Copyright (C) 2020 Alexander Potylitsin <apotyn@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ *
+ ****************************************************************************/
+
+/*****************************************************************************
+ * hashbench: runtime throughput of the functions in hashfns.h
+ *
+ * Every function is measured on three key length distributions, with a
+ * working set that stays in cache (warm) and one much larger than the last
+ * level cache visited in random order (cold), on one thread and on all
+ * online cores. Results are printed as CSV or JSON.
+ *
+ * usage: hashbench [-j] [-t seconds] [-m cold MiB] [-f function] [-d dist]
+ *   -j  JSON instead of CSV
+ *   -t  minimal time of one measurement, default 0.2
+ *   -m  size of the cold working set, default 256
+ *   -f  only functions whose name contains the string
+ *   -d  only the named distribution: ident, url or blob
+ ****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "hashfns.h"
+
+
+enum kind {
+	KIND_CSTR,
+	KIND_MEM,
+	KIND_CSTR64,
+	KIND_MEM64,
+	KIND_SEEDED,
+	KIND_STREAM,
+	KIND_MANY,
+};
+
+struct hashfn {
+	const char * name;
+	enum kind kind;
+	union {
+		unsigned int (* cstr)(const char *);
+		unsigned int (* mem)(const void *, size_t);
+		uint64_t (* cstr64)(const char *);
+		uint64_t (* mem64)(const void *, size_t);
+		unsigned int (* seeded)(const char *, uint32_t);
+		struct {
+			uint32_t (* init)(void);
+			uint32_t (* update)(uint32_t, const void *, size_t);
+			unsigned int (* final)(uint32_t);
+		} stream;
+		void (* many)(const char * const *, const size_t *, size_t, uint32_t *);
+	} fn;
+};
+
+#define HASHFN_ENTRY(f, k, member) { .name = #f, .kind = k, .fn = { .member = f } },
+
+static const struct hashfn hashfns[] = {
+#define HASHFN(f) HASHFN_ENTRY(f, KIND_CSTR, cstr)
+#define HASHFN_N(f) HASHFN_ENTRY(f, KIND_MEM, mem)
+#define HASHFN64(f) HASHFN_ENTRY(f, KIND_CSTR64, cstr64)
+#define HASHFN64_N(f) HASHFN_ENTRY(f, KIND_MEM64, mem64)
+#define HASHFN_SEEDED(f) HASHFN_ENTRY(f, KIND_SEEDED, seeded)
+#define HASHFN_STREAM(f) \
+	{ .name = #f "_update", .kind = KIND_STREAM, \
+		.fn = { .stream = { f##_init, f##_update, f##_final } } },
+#define HASHFN_MANY(f) HASHFN_ENTRY(f, KIND_MANY, many)
+#include "hashfns.def"
+};
+
+#undef HASHFN_ENTRY
+
+static const char * const kind_names[] = { "cstr", "mem", "cstr64", "mem64", "seeded", "stream", "many" };
+
+struct dist {
+	const char * name;
+	size_t min_len;
+	size_t max_len;
+};
+
+static const struct dist dists[] = {
+	{ "ident", 4, 16 },
+	{ "url", 32, 128 },
+	{ "blob", 4096, 4096 },
+};
+
+/* warm working sets fit in L2 of any recent core */
+#define WARM_BYTES (128 * 1024)
+
+struct keyset {
+	char * arena;
+	const char ** keys;
+	size_t * lens;
+	size_t n;
+	size_t bytes;
+};
+
+static uint64_t rng_state = 0x9E3779B97F4A7C15ULL;
+
+static uint64_t rng(void) {
+	/* xorshift64* */
+	rng_state ^= rng_state >> 12;
+	rng_state ^= rng_state << 25;
+	rng_state ^= rng_state >> 27;
+	return rng_state * 0x2545F4914F6CDD1DULL;
+}
+
+/* builds keys of the distribution filling about bytes, in random order. */
+static void keyset_init(struct keyset * ks, const struct dist * d, size_t bytes) {
+	static const char alphabet[] =
+		"abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_/.-?=&";
+	const size_t avg = (d->min_len + d->max_len) / 2 + 1;
+	size_t n = bytes / avg;
+	if (n < 16) n = 16;
+
+	ks->arena = malloc(n * (d->max_len + 1));
+	ks->keys = malloc(n * sizeof(*ks->keys));
+	ks->lens = malloc(n * sizeof(*ks->lens));
+	if (!ks->arena || !ks->keys || !ks->lens) {
+		fprintf(stderr, "hashbench: out of memory\n");
+		exit(2);
+	}
+
+	char * p = ks->arena;
+	ks->bytes = 0;
+	for (size_t i = 0; i < n; ++i) {
+		size_t len = d->min_len + rng() % (d->max_len - d->min_len + 1);
+		for (size_t j = 0; j < len; ++j) {
+			p[j] = alphabet[rng() % (sizeof(alphabet) - 1)];
+		}
+		p[len] = 0;
+		ks->keys[i] = p;
+		ks->lens[i] = len;
+		ks->bytes += len;
+		p += len + 1;
+	}
+	ks->n = n;
+
+	/* visit keys out of memory order, so prefetching does not hide misses */
+	for (size_t i = n - 1; i > 0; --i) {
+		size_t j = rng() % (i + 1);
+		const char * k = ks->keys[i];
+		size_t l = ks->lens[i];
+		ks->keys[i] = ks->keys[j];
+		ks->lens[i] = ks->lens[j];
+		ks->keys[j] = k;
+		ks->lens[j] = l;
+	}
+}
+
+static void keyset_free(struct keyset * ks) {
+	free(ks->arena);
+	free(ks->keys);
+	free(ks->lens);
+}
+
+static double now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* hashes the whole key set once, returns a value depending on all hashes. */
+static uint64_t hash_all(const struct hashfn * h, const struct keyset * ks, uint32_t * out) {
+	uint64_t sum = 0;
+	size_t i;
+
+	switch (h->kind) {
+		case KIND_CSTR:
+			for (i = 0; i < ks->n; ++i) sum += h->fn.cstr(ks->keys[i]);
+			break;
+		case KIND_MEM:
+			for (i = 0; i < ks->n; ++i) sum += h->fn.mem(ks->keys[i], ks->lens[i]);
+			break;
+		case KIND_CSTR64:
+			for (i = 0; i < ks->n; ++i) sum += h->fn.cstr64(ks->keys[i]);
+			break;
+		case KIND_MEM64:
+			for (i = 0; i < ks->n; ++i) sum += h->fn.mem64(ks->keys[i], ks->lens[i]);
+			break;
+		case KIND_SEEDED:
+			for (i = 0; i < ks->n; ++i) sum += h->fn.seeded(ks->keys[i], 0x9747b28cU);
+			break;
+		case KIND_STREAM:
+			for (i = 0; i < ks->n; ++i) {
+				sum += h->fn.stream.final(h->fn.stream.update(h->fn.stream.init(), ks->keys[i], ks->lens[i]));
+			}
+			break;
+		case KIND_MANY:
+			h->fn.many(ks->keys, ks->lens, ks->n, out);
+			for (i = 0; i < ks->n; ++i) sum += out[i];
+			break;
+	}
+	return sum;
+}
+
+struct worker {
+	pthread_t thread;
+	const struct hashfn * h;
+	const struct keyset * ks;
+	pthread_barrier_t * start;
+	size_t rounds;
+	uint64_t sink;
+};
+
+static void * worker_run(void * arg) {
+	struct worker * w = arg;
+	uint32_t * out = malloc(w->ks->n * sizeof(*out));
+	if (!out) {
+		fprintf(stderr, "hashbench: out of memory\n");
+		exit(2);
+	}
+	pthread_barrier_wait(w->start);
+	for (size_t r = 0; r < w->rounds; ++r) {
+		w->sink += hash_all(w->h, w->ks, out);
+	}
+	free(out);
+	return NULL;
+}
+
+/* seconds for nthreads threads hashing the key set rounds times each. */
+static double run(const struct hashfn * h, const struct keyset * ks, unsigned int nthreads, size_t rounds) {
+	struct worker * w = calloc(nthreads, sizeof(*w));
+	pthread_barrier_t start;
+	static volatile uint64_t sink;
+
+	pthread_barrier_init(&start, NULL, nthreads + 1);
+	for (unsigned int t = 0; t < nthreads; ++t) {
+		w[t].h = h;
+		w[t].ks = ks;
+		w[t].start = &start;
+		w[t].rounds = rounds;
+		pthread_create(&w[t].thread, NULL, worker_run, &w[t]);
+	}
+
+	double t0 = now();
+	pthread_barrier_wait(&start);
+	for (unsigned int t = 0; t < nthreads; ++t) {
+		pthread_join(w[t].thread, NULL);
+		sink += w[t].sink;
+	}
+	double elapsed = now() - t0;
+
+	pthread_barrier_destroy(&start);
+	free(w);
+	return elapsed;
+}
+
+struct result {
+	double ns_per_key;
+	double gb_per_s;
+};
+
+/* best of three runs, each long enough to be timed reliably. */
+static struct result measure(const struct hashfn * h, const struct keyset * ks, unsigned int nthreads, double min_time) {
+	size_t rounds = 1;
+	double best = 0;
+
+	/* warm up and calibrate */
+	for (;;) {
+		double t = run(h, ks, nthreads, rounds);
+		if (t >= min_time / 4) {
+			rounds = (size_t)(rounds * (min_time / t)) + 1;
+			break;
+		}
+		rounds *= 4;
+	}
+	for (int i = 0; i < 3; ++i) {
+		double t = run(h, ks, nthreads, rounds);
+		if (i == 0 || t < best) best = t;
+	}
+
+	const double keys = (double)ks->n * rounds * nthreads;
+	const double bytes = (double)ks->bytes * rounds * nthreads;
+	struct result r = {
+		.ns_per_key = best * 1e9 / keys,
+		.gb_per_s = bytes / best / 1e9,
+	};
+	return r;
+}
+
+int main(int argc, char ** argv) {
+	const char * only_fn = NULL;
+	const char * only_dist = NULL;
+	double min_time = 0.2;
+	size_t cold_mib = 256;
+	bool json = false;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "jt:m:f:d:")) != -1) {
+		switch (opt) {
+			case 'j': json = true; break;
+			case 't': min_time = atof(optarg); break;
+			case 'm': cold_mib = (size_t)atol(optarg); break;
+			case 'f': only_fn = optarg; break;
+			case 'd': only_dist = optarg; break;
+			default:
+				fprintf(stderr, "usage: %s [-j] [-t seconds] [-m cold MiB] [-f function] [-d dist]\n", argv[0]);
+				return 2;
+		}
+	}
+
+	long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+	const unsigned int threads[] = { 1, ncpu > 1 ? (unsigned int)ncpu : 1 };
+	const unsigned int nthreads_variants = (threads[1] > 1) ? 2 : 1;
+	bool first = true;
+
+	if (json) {
+		printf("[\n");
+	}
+	else {
+		printf("function,kind,dist,cache,threads,keys,bytes,ns_per_key,gb_per_s\n");
+	}
+
+	for (size_t d = 0; d < sizeof(dists) / sizeof(dists[0]); ++d) {
+		if (only_dist && strcmp(only_dist, dists[d].name) != 0) continue;
+
+		for (int cold = 0; cold < 2; ++cold) {
+			struct keyset ks;
+			keyset_init(&ks, &dists[d], cold ? cold_mib << 20 : WARM_BYTES);
+
+			for (size_t f = 0; f < sizeof(hashfns) / sizeof(hashfns[0]); ++f) {
+				const struct hashfn * h = &hashfns[f];
+				if (only_fn && !strstr(h->name, only_fn)) continue;
+
+				for (unsigned int t = 0; t < nthreads_variants; ++t) {
+					struct result r = measure(h, &ks, threads[t], min_time);
+					if (json) {
+						printf("%s  {\"function\": \"%s\", \"kind\": \"%s\", \"dist\": \"%s\", "
+							"\"cache\": \"%s\", \"threads\": %u, \"keys\": %zu, \"bytes\": %zu, "
+							"\"ns_per_key\": %.3f, \"gb_per_s\": %.3f}",
+							first ? "" : ",\n", h->name, kind_names[h->kind], dists[d].name,
+							cold ? "cold" : "warm", threads[t], ks.n, ks.bytes,
+							r.ns_per_key, r.gb_per_s);
+					}
+					else {
+						printf("%s,%s,%s,%s,%u,%zu,%zu,%.3f,%.3f\n",
+							h->name, kind_names[h->kind], dists[d].name,
+							cold ? "cold" : "warm", threads[t], ks.n, ks.bytes,
+							r.ns_per_key, r.gb_per_s);
+					}
+					first = false;
+					fflush(stdout);
+				}
+			}
+
+			keyset_free(&ks);
+		}
+	}
+
+	if (json) {
+		printf("\n]\n");
+	}
+	return 0;
+}
+
+/* vim: set ts=4 tw=78 noet: */
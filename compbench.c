@@ -0,0 +1,389 @@
+/*****************************************************************************
+ * Copyright (C) 2020 Alexander Potylitsin <apotyn@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ *
+ ****************************************************************************/
+
+/*****************************************************************************
+ * compbench: compile time overhead of the strhash plugin
+ *
+ * Generates synthetic translation units full of hash calls and compiles each
+ * of them without and with the plugin, reporting wall time, peak RSS of the
+ * compiler and the number of calls the plugin folded (from its stats=
+ * output). Shapes of the generated code:
+ *   small   many functions of 16 calls
+ *   large   functions of up to 16384 calls in straight line code
+ *   nested  functions of 512 calls spread over 32 levels of ifs and loops
+ * Every call has a literal argument with the given probability, otherwise
+ * an argument of the enclosing function.
+ *
+ * usage: compbench [-j] [-k] [-p strhash.so] [-c compiler] [-I hashfns dir]
+ *                  [-w work dir] [-n calls,...] [-s shape,...] [-l pct,...]
+ *                  [-- compiler flags]
+ ****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+
+enum shape {
+	SHAPE_SMALL,
+	SHAPE_LARGE,
+	SHAPE_NESTED,
+};
+
+static const char * const shape_names[] = { "small", "large", "nested" };
+static const unsigned long shape_calls_per_function[] = { 16, 16384, 512 };
+
+#define NESTED_DEPTH 32
+
+/* called functions, by argument form */
+static const char * const cstr_hashfns[] = {
+	"pjw_hash", "fnv1a_hash", "djb2_hash", "murmur3_hash",
+};
+static const char * const mem_hashfns[] = {
+	"fnv1a_hash_n", "xxh32_hash_n",
+};
+
+static unsigned long rng_state = 88172645463325252UL;
+
+static unsigned long rng(void) {
+	/* xorshift64 */
+	rng_state ^= rng_state << 13;
+	rng_state ^= rng_state >> 7;
+	rng_state ^= rng_state << 17;
+	return rng_state;
+}
+
+static const char tabs[NESTED_DEPTH + 2] =
+	"\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t";
+
+static void gen_call(FILE * f, unsigned long k, unsigned int literal_pct, int indent) {
+	const bool literal = rng() % 100 < literal_pct;
+	const bool mem = rng() % 4 == 0;
+
+	fprintf(f, "%.*s", indent, tabs);
+	if (mem) {
+		const char * fn = mem_hashfns[k % (sizeof(mem_hashfns) / sizeof(mem_hashfns[0]))];
+		if (literal) {
+			char key[32];
+			int len = snprintf(key, sizeof(key), "key_%lx", k);
+			fprintf(f, "h += %s(\"%s\", %d);\n", fn, key, len);
+		}
+		else {
+			fprintf(f, "h += %s(v[%lu], n);\n", fn, k & 7);
+		}
+	}
+	else {
+		const char * fn = cstr_hashfns[k % (sizeof(cstr_hashfns) / sizeof(cstr_hashfns[0]))];
+		if (literal) {
+			fprintf(f, "h += %s(\"key_%lx\");\n", fn, k);
+		}
+		else {
+			fprintf(f, "h += %s(v[%lu]);\n", fn, k & 7);
+		}
+	}
+}
+
+/* writes a translation unit of calls hash calls of the shape into path. */
+static int generate(const char * path, enum shape shape, unsigned long calls, unsigned int literal_pct) {
+	FILE * f = fopen(path, "w");
+	if (!f) {
+		fprintf(stderr, "compbench: %s: %s\n", path, strerror(errno));
+		return -1;
+	}
+
+	const unsigned long per_fn = shape_calls_per_function[shape];
+	unsigned long k = 0;
+
+	fprintf(f, "#include <stddef.h>\n#include \"hashfns.h\"\n\n");
+	for (unsigned long fn = 0; k < calls; ++fn) {
+		unsigned long end = (calls - k > per_fn) ? k + per_fn : calls;
+
+		fprintf(f, "unsigned long f%lu(const char * const * v, size_t n) {\n", fn);
+		fprintf(f, "\tunsigned long h = 0;\n");
+
+		if (SHAPE_NESTED == shape) {
+			const unsigned long per_level = (end - k + NESTED_DEPTH - 1) / NESTED_DEPTH;
+			int depth;
+
+			for (depth = 0; depth < NESTED_DEPTH && k < end; ++depth) {
+				for (unsigned long i = 0; i < per_level && k < end; ++i, ++k) {
+					gen_call(f, k, literal_pct, depth + 1);
+				}
+				fprintf(f, "%.*s", depth + 1, tabs);
+				if (depth & 1) {
+					fprintf(f, "for (size_t i%d = 0; i%d < n; ++i%d) {\n", depth, depth, depth);
+				}
+				else {
+					fprintf(f, "if (h & %luUL) {\n", 1UL << (depth % 64));
+				}
+			}
+			while (depth-- > 0) {
+				fprintf(f, "%.*s}\n", depth + 1, tabs);
+			}
+		}
+		else {
+			for (; k < end; ++k) {
+				gen_call(f, k, literal_pct, 1);
+			}
+		}
+
+		fprintf(f, "\treturn h;\n}\n\n");
+	}
+
+	if (fclose(f) != 0) {
+		fprintf(stderr, "compbench: %s: %s\n", path, strerror(errno));
+		return -1;
+	}
+	return 0;
+}
+
+struct result {
+	int status;
+	double wall;
+	long maxrss_kib;
+	long folded;
+};
+
+static double now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* returns calls_folded of the last line of a stats= file, or -1. */
+static long read_folded(const char * path) {
+	FILE * f = fopen(path, "r");
+	char line[4096];
+	long folded = -1;
+
+	if (!f) {
+		return -1;
+	}
+	while (fgets(line, sizeof(line), f)) {
+		const char * p = strstr(line, "\"calls_folded\": ");
+		if (p) {
+			folded = strtol(p + strlen("\"calls_folded\": "), NULL, 10);
+		}
+	}
+	fclose(f);
+	return folded;
+}
+
+/*
+ * runs the compiler on the source, with the plugin when plugin is not NULL.
+ * wait4 accounts the reaped cc1 as well, so maxrss is of the real compiler.
+ */
+static struct result compile(char * const * base_argv, int base_argc,
+	const char * src, const char * obj, const char * plugin, const char * stats) {
+	struct result r = { .status = -1, .wall = 0, .maxrss_kib = 0, .folded = -1 };
+	const char * argv[base_argc + 8];
+	char plugin_arg[4200], stats_arg[4200];
+	int argc = 0;
+
+	for (int i = 0; i < base_argc; ++i) {
+		argv[argc++] = base_argv[i];
+	}
+	argv[argc++] = "-c";
+	argv[argc++] = src;
+	argv[argc++] = "-o";
+	argv[argc++] = obj;
+	if (plugin) {
+		snprintf(plugin_arg, sizeof(plugin_arg), "-fplugin=%s", plugin);
+		snprintf(stats_arg, sizeof(stats_arg), "-fplugin-arg-strhash-stats=%s", stats);
+		argv[argc++] = plugin_arg;
+		argv[argc++] = stats_arg;
+		unlink(stats);
+	}
+	argv[argc] = NULL;
+
+	double t0 = now();
+	pid_t pid = fork();
+	if (pid < 0) {
+		fprintf(stderr, "compbench: fork: %s\n", strerror(errno));
+		return r;
+	}
+	if (0 == pid) {
+		execvp(argv[0], (char * const *)argv);
+		fprintf(stderr, "compbench: %s: %s\n", argv[0], strerror(errno));
+		_exit(127);
+	}
+
+	struct rusage ru;
+	int status;
+	while (wait4(pid, &status, 0, &ru) < 0) {
+		if (EINTR != errno) {
+			fprintf(stderr, "compbench: wait4: %s\n", strerror(errno));
+			return r;
+		}
+	}
+	r.wall = now() - t0;
+	r.maxrss_kib = ru.ru_maxrss;
+	r.status = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+	if (plugin) {
+		r.folded = read_folded(stats);
+		unlink(stats);
+	}
+	unlink(obj);
+	return r;
+}
+
+static size_t split(char * list, char ** items, size_t max) {
+	size_t n = 0;
+	for (char * t = strtok(list, ","); t && n < max; t = strtok(NULL, ",")) {
+		items[n++] = t;
+	}
+	return n;
+}
+
+int main(int argc, char ** argv) {
+	char sizes_list[256] = "10000,100000,1000000";
+	char shapes_list[256] = "small,large,nested";
+	char literals_list[256] = "100,50,0";
+	const char * plugin = NULL;
+	const char * compiler = "gcc";
+	const char * incdir = ".";
+	const char * workdir = "/tmp";
+	bool json = false;
+	bool keep = false;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "jkp:c:I:w:n:s:l:")) != -1) {
+		switch (opt) {
+			case 'j': json = true; break;
+			case 'k': keep = true; break;
+			case 'p': plugin = optarg; break;
+			case 'c': compiler = optarg; break;
+			case 'I': incdir = optarg; break;
+			case 'w': workdir = optarg; break;
+			case 'n': snprintf(sizes_list, sizeof(sizes_list), "%s", optarg); break;
+			case 's': snprintf(shapes_list, sizeof(shapes_list), "%s", optarg); break;
+			case 'l': snprintf(literals_list, sizeof(literals_list), "%s", optarg); break;
+			default:
+				fprintf(stderr,
+					"usage: %s [-j] [-k] [-p strhash.so] [-c compiler] [-I hashfns dir]\n"
+					"       [-w work dir] [-n calls,...] [-s shape,...] [-l pct,...]\n"
+					"       [-- compiler flags]\n", argv[0]);
+				return 2;
+		}
+	}
+
+	char * sizes[16], * shapes[16], * literals[16];
+	const size_t nsizes = split(sizes_list, sizes, 16);
+	const size_t nshapes = split(shapes_list, shapes, 16);
+	const size_t nliterals = split(literals_list, literals, 16);
+
+	/* compiler, include dir and the flags after -- (-O2 when none) */
+	char incarg[4096];
+	char * base_argv[argc + 4];
+	int base_argc = 0;
+	snprintf(incarg, sizeof(incarg), "-I%s", incdir);
+	base_argv[base_argc++] = (char *)compiler;
+	base_argv[base_argc++] = incarg;
+	if (optind < argc) {
+		while (optind < argc) base_argv[base_argc++] = argv[optind++];
+	}
+	else {
+		base_argv[base_argc++] = (char *)"-O2";
+	}
+
+	char src[4096], obj[4096], stats[4096];
+	const long pid = (long)getpid();
+	snprintf(src, sizeof(src), "%s/compbench-%ld.c", workdir, pid);
+	snprintf(obj, sizeof(obj), "%s/compbench-%ld.o", workdir, pid);
+	snprintf(stats, sizeof(stats), "%s/compbench-%ld.stats", workdir, pid);
+
+	bool first = true;
+	int ret = 0;
+
+	if (json) {
+		printf("[\n");
+	}
+	else {
+		printf("shape,calls,literal_pct,plugin,status,wall_s,maxrss_kib,folded\n");
+	}
+
+	for (size_t s = 0; s < nshapes; ++s) {
+		enum shape shape;
+		for (shape = SHAPE_SMALL; shape <= SHAPE_NESTED; shape = (enum shape)(shape + 1)) {
+			if (0 == strcmp(shapes[s], shape_names[shape])) break;
+		}
+		if (shape > SHAPE_NESTED) {
+			fprintf(stderr, "compbench: unknown shape %s\n", shapes[s]);
+			return 2;
+		}
+
+		for (size_t n = 0; n < nsizes; ++n) {
+			const unsigned long calls = strtoul(sizes[n], NULL, 10);
+
+			for (size_t l = 0; l < nliterals; ++l) {
+				const unsigned int pct = (unsigned int)atoi(literals[l]);
+
+				if (generate(src, shape, calls, pct) != 0) {
+					return 1;
+				}
+
+				for (int with_plugin = 0; with_plugin <= (plugin ? 1 : 0); ++with_plugin) {
+					struct result r = compile(base_argv, base_argc, src, obj,
+						with_plugin ? plugin : NULL, stats);
+					if (r.status != 0) ret = 1;
+
+					if (json) {
+						printf("%s  {\"shape\": \"%s\", \"calls\": %lu, \"literal_pct\": %u, "
+							"\"plugin\": %s, \"status\": %d, \"wall_s\": %.3f, "
+							"\"maxrss_kib\": %ld, \"folded\": %ld}",
+							first ? "" : ",\n", shape_names[shape], calls, pct,
+							with_plugin ? "true" : "false", r.status, r.wall,
+							r.maxrss_kib, r.folded);
+					}
+					else {
+						printf("%s,%lu,%u,%d,%d,%.3f,%ld,%ld\n",
+							shape_names[shape], calls, pct, with_plugin,
+							r.status, r.wall, r.maxrss_kib, r.folded);
+					}
+					first = false;
+					fflush(stdout);
+				}
+
+				if (keep) {
+					char kept[4096];
+					snprintf(kept, sizeof(kept), "%s/compbench-%s-%lu-%u.c",
+						workdir, shape_names[shape], calls, pct);
+					rename(src, kept);
+				}
+				else {
+					unlink(src);
+				}
+			}
+		}
+	}
+
+	if (json) {
+		printf("\n]\n");
+	}
+	return ret;
+}
+
+/* vim: set ts=4 tw=78 noet: */
@@ -35,7 +35,7 @@ struct GCC_CONCAT2(name, _pass): gimple_opt_pass { \
 		return execfn(udata, fn); \
 	}\
 	virtual GCC_CONCAT2(name, _pass) * clone() override { \
-		return this; \
+		return new GCC_CONCAT2(name, _pass)(m_ctxt, udata); \
 	} \
 	void * udata; \
 };
@@ -43,12 +43,20 @@ void logver(const char * prefix, const struct plugin_gcc_version * version) {
 size_t escaped(char * buf, size_t n, const char * s, size_t len) {
 	size_t p, i;
 
-	for (p = 0, i = 0; p < n && i < len; ++i) {
-		if (s[i] >= 32 && s[i] <= 127) {
-			buf[p++] = s[i];
+	if (n == 0) {
+		return 0;
+	}
+
+	buf[0] = 0;
+	for (p = 0, i = 0; i < len; ++i) {
+		unsigned char c = (unsigned char)s[i];
+		if (c >= 32 && c < 127 && c != '\\') {
+			if (p + 1 >= n) break;
+			buf[p++] = c;
 		}
 		else {
-			p += snprintf(buf + p, n - p, "\\x%02x", s[i]);
+			if (p + 4 >= n) break;
+			p += snprintf(buf + p, n - p, "\\x%02x", c);
 		}
 		buf[p] = 0;
 	}
@@ -0,0 +1,129 @@
+/*****************************************************************************
+ * Copyright (C) 2020 Alexander Potylitsin <apotyn@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ *
+ ****************************************************************************/
+
+/*****************************************************************************
+ * hashcheck-gen: writes the key corpus of hashcheck as a header
+ *
+ * HASHCHECK_KEYS(X, f) expands to X(f, "key") for every key: all lengths
+ * up to 64 bytes, identifiers, printable text, any non-NUL bytes and a few
+ * keys of up to 8 KiB, which take the long block paths of xxh64, wyhash and
+ * the CRC-32C instruction. Keys have no NULs so that every function taking
+ * a NUL-terminated string hashes them whole.
+ *
+ * usage: hashcheck-gen [-n keys] [-s seed] > hashcheck-keys.h
+ ****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#define SHORT_KEYS 65
+#define LONG_KEY_MAX 8192
+
+static uint64_t rng_state;
+
+/* xorshift64*, the same generator as hashbench */
+static uint64_t rng(void) {
+	rng_state ^= rng_state >> 12;
+	rng_state ^= rng_state << 25;
+	rng_state ^= rng_state >> 27;
+	return rng_state * 0x2545F4914F6CDD1DULL;
+}
+
+static unsigned int rng_below(unsigned int n) {
+	return (unsigned int)(rng() % n);
+}
+
+/* as a C and C++ string literal, '?' is escaped against trigraphs */
+static void put_byte(unsigned char c) {
+	if ('"' == c || '\\' == c || '?' == c) {
+		printf("\\%c", c);
+	}
+	else
+	if (c >= 0x20 && c < 0x7f) {
+		putchar(c);
+	}
+	else {
+		printf("\\%03o", c);
+	}
+}
+
+static void put_key(unsigned int kind, size_t len) {
+	static const char ident[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ_0123456789";
+
+	printf("\tX(f, \"");
+	for (size_t i = 0; i < len; ++i) {
+		switch (kind) {
+			case 0:
+				/* no digit first */
+				put_byte((unsigned char)ident[rng_below(i ? sizeof(ident) - 1 : sizeof(ident) - 11)]);
+				break;
+			case 1:
+				put_byte((unsigned char)(0x20 + rng_below(0x5f)));
+				break;
+			default:
+				put_byte((unsigned char)(1 + rng_below(255)));
+				break;
+		}
+	}
+	printf("\") \\\n");
+}
+
+int main(int argc, char ** argv) {
+	unsigned long nkeys = 4096;
+	int opt;
+
+	rng_state = 0x5eed;
+	while ((opt = getopt(argc, argv, "n:s:")) != -1) {
+		switch (opt) {
+			case 'n': nkeys = strtoul(optarg, NULL, 0); break;
+			case 's': rng_state = strtoull(optarg, NULL, 0) | 1; break;
+			default:
+				fprintf(stderr, "usage: %s [-n keys] [-s seed]\n", argv[0]);
+				return 2;
+		}
+	}
+	if (nkeys < SHORT_KEYS) {
+		nkeys = SHORT_KEYS;
+	}
+
+	printf("/* generated by hashcheck-gen, do not edit */\n\n");
+	printf("#define HASHCHECK_NKEYS %lu\n", nkeys);
+	printf("#define HASHCHECK_SEED 0x%08xU\n\n", (unsigned int)rng());
+	printf("#define HASHCHECK_KEYS(X, f) \\\n");
+
+	for (unsigned long k = 0; k < nkeys; ++k) {
+		if (k < SHORT_KEYS) {
+			put_key(2, k);
+		}
+		else
+		if (0 == rng_below(64)) {
+			put_key(2, 65 + rng_below(LONG_KEY_MAX - 64));
+		}
+		else {
+			const unsigned int kind = rng_below(3);
+			put_key(kind, rng_below(kind ? 129 : 33));
+		}
+	}
+	printf("\n");
+
+	return 0;
+}
+
+/* vim: set ts=4 tw=78 noet: */
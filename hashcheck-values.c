@@ -0,0 +1,70 @@
+/*****************************************************************************
+ * Copyright (C) 2020 Alexander Potylitsin <apotyn@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ *
+ ****************************************************************************/
+
+/*
+ * Hash values of the hashcheck corpus computed while compiling, for every
+ * function of hashfns.def taking a string, key by key. Built as C++ it
+ * gives hashcheck_const from hashfns.hpp, built as C with the plugin it
+ * gives hashcheck_folded from the __builtin_strhash_ folding; both arrays
+ * are static initializers, so a value the compiler can not compute is an
+ * error rather than a runtime call.
+ */
+
+#include <stdint.h>
+
+#include "hashcheck-keys.h"
+
+#ifdef __cplusplus
+
+#include "hashfns.hpp"
+
+#define CSTR(f, K) strhash::f(K),
+#define MEM(f, K) strhash::f(K, sizeof(K) - 1),
+#define SEEDED(f, K) strhash::f(K, HASHCHECK_SEED),
+
+static constexpr uint64_t values[] = {
+#	define HASHFN(f) HASHCHECK_KEYS(CSTR, f)
+#	define HASHFN_N(f) HASHCHECK_KEYS(MEM, f)
+#	define HASHFN64(f) HASHCHECK_KEYS(CSTR, f)
+#	define HASHFN64_N(f) HASHCHECK_KEYS(MEM, f)
+#	define HASHFN_SEEDED(f) HASHCHECK_KEYS(SEEDED, f)
+#	include "hashfns.def"
+};
+
+extern "C" const uint64_t * const hashcheck_const = values;
+
+#else
+
+#include "hashfns.h"
+
+#define CSTR(f, K) STRHASH_CONST(f, K),
+#define MEM(f, K) STRHASH_CONST(f, K, sizeof(K) - 1),
+#define SEEDED(f, K) STRHASH_CONST(f, K, HASHCHECK_SEED),
+
+const uint64_t hashcheck_folded[] = {
+#	define HASHFN(f) HASHCHECK_KEYS(CSTR, f)
+#	define HASHFN_N(f) HASHCHECK_KEYS(MEM, f)
+#	define HASHFN64(f) HASHCHECK_KEYS(CSTR, f)
+#	define HASHFN64_N(f) HASHCHECK_KEYS(MEM, f)
+#	define HASHFN_SEEDED(f) HASHCHECK_KEYS(SEEDED, f)
+#	include "hashfns.def"
+};
+
+#endif
+
+/* vim: set ts=4 tw=78 noet: */
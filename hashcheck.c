@@ -0,0 +1,115 @@
+/*****************************************************************************
+ * Copyright (C) 2020 Alexander Potylitsin <apotyn@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ *
+ ****************************************************************************/
+
+/*****************************************************************************
+ * hashcheck: hashfns.c, hashfns.hpp and the plugin agree on every key
+ *
+ * Every function of hashfns.def taking a string is called at runtime on
+ * the keys of hashcheck-keys.h and compared to the constexpr values of
+ * hashfns.hpp and to the values folded by the plugin, see
+ * hashcheck-values.c. Without the folded object linked only the first two
+ * are compared. Exits with 1 on any difference.
+ ****************************************************************************/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+
+#include "hashfns.h"
+#include "hashcheck-keys.h"
+
+enum kind { KIND_CSTR, KIND_MEM, KIND_CSTR64, KIND_MEM64, KIND_SEEDED };
+
+struct hashfn {
+	const char * name;
+	enum kind kind;
+	union {
+		unsigned int (* cstr)(const char *);
+		unsigned int (* mem)(const void *, size_t);
+		uint64_t (* cstr64)(const char *);
+		uint64_t (* mem64)(const void *, size_t);
+		unsigned int (* seeded)(const char *, uint32_t);
+	} fn;
+};
+
+/* the order of hashcheck-values.c */
+static const struct hashfn hashfns[] = {
+#define HASHFN_ENTRY(f, k, member) { .name = #f, .kind = k, .fn = { .member = f } },
+#define HASHFN(f) HASHFN_ENTRY(f, KIND_CSTR, cstr)
+#define HASHFN_N(f) HASHFN_ENTRY(f, KIND_MEM, mem)
+#define HASHFN64(f) HASHFN_ENTRY(f, KIND_CSTR64, cstr64)
+#define HASHFN64_N(f) HASHFN_ENTRY(f, KIND_MEM64, mem64)
+#define HASHFN_SEEDED(f) HASHFN_ENTRY(f, KIND_SEEDED, seeded)
+#include "hashfns.def"
+#undef HASHFN_ENTRY
+};
+
+#define KEY(f, K) K,
+#define LEN(f, K) sizeof(K) - 1,
+
+static const char * const keys[] = { HASHCHECK_KEYS(KEY, _) };
+static const size_t lens[] = { HASHCHECK_KEYS(LEN, _) };
+
+extern const uint64_t * const hashcheck_const;
+extern const uint64_t hashcheck_folded[] __attribute__((weak));
+
+static uint64_t call(const struct hashfn * h, size_t k) {
+	switch (h->kind) {
+		case KIND_CSTR: return h->fn.cstr(keys[k]);
+		case KIND_MEM: return h->fn.mem(keys[k], lens[k]);
+		case KIND_CSTR64: return h->fn.cstr64(keys[k]);
+		case KIND_MEM64: return h->fn.mem64(keys[k], lens[k]);
+		case KIND_SEEDED: return h->fn.seeded(keys[k], HASHCHECK_SEED);
+	}
+	return 0;
+}
+
+int main(void) {
+	const size_t nfns = sizeof(hashfns) / sizeof(hashfns[0]);
+	const uint64_t * folded = hashcheck_folded;
+	size_t failed = 0;
+
+	for (size_t f = 0; f < nfns; ++f) {
+		size_t bad = 0;
+		for (size_t k = 0; k < HASHCHECK_NKEYS; ++k) {
+			const size_t i = f * HASHCHECK_NKEYS + k;
+			const uint64_t v = call(&hashfns[f], k);
+			if (v == hashcheck_const[i] && (!folded || v == folded[i])) {
+				continue;
+			}
+			if (!bad++) {
+				fprintf(stderr, "%s: key %zu of %zu bytes: runtime 0x%" PRIx64 ", constexpr 0x%" PRIx64,
+					hashfns[f].name, k, lens[k], v, hashcheck_const[i]);
+				if (folded) {
+					fprintf(stderr, ", plugin 0x%" PRIx64, folded[i]);
+				}
+				fprintf(stderr, "\n");
+			}
+		}
+		if (bad) {
+			fprintf(stderr, "%s: %zu of %d keys differ\n", hashfns[f].name, bad, HASHCHECK_NKEYS);
+			++failed;
+		}
+	}
+
+	printf("hashcheck: %zu functions, %d keys, runtime and constexpr%s: %s\n",
+		nfns, HASHCHECK_NKEYS, folded ? " and plugin" : "", failed ? "FAILED" : "ok");
+	return failed ? 1 : 0;
+}
+
+/* vim: set ts=4 tw=78 noet: */
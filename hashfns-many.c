@@ -0,0 +1,320 @@
+/*****************************************************************************
+ * Copyright (C) 2020 Alexander Potylitsin <apotyn@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ *
+ ****************************************************************************/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "hashfns.h"
+
+
+/*****************************************************************************
+ * batch hashing
+ *
+ * A group of keys is hashed in parallel, one key per 32-bit vector lane.
+ * Keys are transposed chunk by chunk into a lane-interleaved buffer, so the
+ * inner loop is a plain vector load followed by the hash steps. Lanes whose
+ * key is already exhausted keep their value through a compare mask, which
+ * makes every lane compute exactly what xxx_hash_n() computes.
+ *
+ * Vectors are GCC generic vectors, compiled once per target: 8 lanes for
+ * the SSE2 baseline (two xmm registers), 8 lanes for AVX2 and 16 lanes for
+ * AVX-512F. The kernel is chosen at runtime from the CPU features.
+ ****************************************************************************/
+
+typedef uint32_t vec8u __attribute__((vector_size(8 * sizeof(uint32_t))));
+typedef uint32_t vec16u __attribute__((vector_size(16 * sizeof(uint32_t))));
+
+/* bytes transposed per chunk for every lane */
+#define CHUNK 64
+
+/* independent vectors per group, see DEFINE_HASH_GROUP */
+#define NV 4
+
+/* the widest group, sizes the per-call scratch arrays */
+#define MAX_LANES (NV * 16)
+
+/* longer keys would stall the whole group, they are hashed by scalar code */
+#define MAX_LANE_LEN 256
+
+/* groups with a shorter average key length are hashed scalar */
+#define MIN_LANE_AVG 24
+
+typedef void (* hash_group_fn)(const char * const * keys, const uint32_t * lens, uint32_t * out);
+typedef unsigned int (* hash_n_fn)(const void * p, size_t len);
+
+/* recurrences shared by all kernels, h and c are vectors of the same type */
+#define FNV1_STEP(h, c)		do { h *= 0x01000193U; h ^= c; } while (0)
+#define FNV1A_STEP(h, c)	do { h ^= c; h *= 0x01000193U; } while (0)
+#define DJB2_STEP(h, c)		do { h = ((h << 5) + h) + c; } while (0)
+#define SDBM_STEP(h, c)		do { h = c + (h << 6) + (h << 16) - h; } while (0)
+#define BKDR_STEP(h, c)		do { h = (h * 131313U) + c; } while (0)
+#define LY_STEP(h, c)		do { h = (h * 1664525U) + c + 1013904223U; } while (0)
+#define FAQ6_STEP(h, c)		do { h += c; h += (h << 10); h ^= (h >> 6); } while (0)
+
+#define NO_FINAL(h)			do { } while (0)
+#define FAQ6_FINAL(h)		do { h += (h << 3); h ^= (h >> 11); h += (h << 15); } while (0)
+
+/*
+ * LANE_BYTE: k-th byte in memory order of every 32-bit word in vector w.
+ * WORD_SKIP: drops n leading bytes of a loaded word, zero filling its end.
+ */
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#	define LANE_BYTE(w, k) (((w) >> (24 - 8 * (k))) & 0xFFU)
+#	define WORD_SKIP(w, n) ((w) << (8 * (n)))
+#else
+#	define LANE_BYTE(w, k) (((w) >> (8 * (k))) & 0xFFU)
+#	define WORD_SKIP(w, n) ((w) >> (8 * (n)))
+#endif
+
+/* one hash step on byte k of words w0..w3 for all four vectors h0..h3 */
+#define STEP4(STEP, vtype, k) \
+	do { \
+		vtype c0 = LANE_BYTE(w0, k), c1 = LANE_BYTE(w1, k); \
+		vtype c2 = LANE_BYTE(w2, k), c3 = LANE_BYTE(w3, k); \
+		STEP(h0, c0); STEP(h1, c1); STEP(h2, c2); STEP(h3, c3); \
+	} while (0)
+
+/* the same, but lanes with len <= pos keep their previous value */
+#define STEP4_MASKED(STEP, vtype, k, pos) \
+	do { \
+		const vtype p_ = (vtype){ 0 } + (pos); \
+		vtype c0 = LANE_BYTE(w0, k), c1 = LANE_BYTE(w1, k); \
+		vtype c2 = LANE_BYTE(w2, k), c3 = LANE_BYTE(w3, k); \
+		vtype n0 = h0, n1 = h1, n2 = h2, n3 = h3; \
+		vtype m0 = (vtype)(len0 > p_), m1 = (vtype)(len1 > p_); \
+		vtype m2 = (vtype)(len2 > p_), m3 = (vtype)(len3 > p_); \
+		STEP(n0, c0); STEP(n1, c1); STEP(n2, c2); STEP(n3, c3); \
+		h0 = (n0 & m0) | (h0 & ~m0); h1 = (n1 & m1) | (h1 & ~m1); \
+		h2 = (n2 & m2) | (h2 & ~m2); h3 = (n3 & m3) | (h3 & ~m3); \
+	} while (0)
+
+/*
+ * Defines name() hashing 4 * W keys at once as four vectors of type vtype
+ * with W lanes each. Independent vectors hide the latency of the multiply
+ * in a single dependency chain.
+ *
+ * Each key is transposed 4 bytes per store into words[][], then every word
+ * row is loaded as four vectors and consumed byte by byte. Near the end of
+ * a key the last 4 bytes are loaded and shifted instead, so the
+ * transposition never reads past a key. Words below the shortest key in
+ * the group need no masking at all.
+ */
+#define DEFINE_HASH_GROUP(name, W, vtype, attrs, INIT, STEP, FINAL) \
+attrs static void name(const char * const * keys, const uint32_t * lens, uint32_t * out) { \
+	uint32_t words[CHUNK / 4][NV * W] __attribute__((aligned(sizeof(vtype)))); \
+	uint32_t minlen = UINT32_MAX, maxlen = 0; \
+	vtype len0, len1, len2, len3; \
+	vtype h0, h1, h2, h3; \
+	unsigned int l; \
+	\
+	for (l = 0; l < NV * W; ++l) { \
+		minlen = (lens[l] < minlen) ? lens[l] : minlen; \
+		maxlen = (lens[l] > maxlen) ? lens[l] : maxlen; \
+	} \
+	memcpy(&len0, lens + 0 * W, sizeof(vtype)); \
+	memcpy(&len1, lens + 1 * W, sizeof(vtype)); \
+	memcpy(&len2, lens + 2 * W, sizeof(vtype)); \
+	memcpy(&len3, lens + 3 * W, sizeof(vtype)); \
+	h0 = h1 = h2 = h3 = (vtype){ 0 } + (uint32_t)(INIT); \
+	\
+	for (uint32_t base = 0; base < maxlen; base += CHUNK) { \
+		const uint32_t span = (maxlen - base < CHUNK) ? (maxlen - base) : CHUNK; \
+		const uint32_t nwords = (span + 3) / 4; \
+		for (l = 0; l < NV * W; ++l) { \
+			const unsigned char * key = (const unsigned char *)keys[l]; \
+			uint32_t len = lens[l]; \
+			unsigned char pad[4] = { 0 }; \
+			if (len < 4) { \
+				for (uint32_t k = 0; k < len; ++k) { \
+					pad[k] = key[k]; \
+				} \
+				key = pad; \
+				len = 4; \
+			} \
+			for (uint32_t j = 0; j < nwords; ++j) { \
+				const uint32_t off = base + 4 * j; \
+				const uint32_t at = (len - 4 >= off) ? off : len - 4; \
+				const uint32_t skip = (off - at < 4) ? off - at : 3; \
+				uint32_t w; \
+				memcpy(&w, key + at, 4); \
+				words[j][l] = WORD_SKIP(w, skip); \
+			} \
+		} \
+		for (uint32_t j = 0; j < nwords; ++j) { \
+			const uint32_t pos = base + 4 * j; \
+			vtype w0, w1, w2, w3; \
+			memcpy(&w0, &words[j][0 * W], sizeof(vtype)); \
+			memcpy(&w1, &words[j][1 * W], sizeof(vtype)); \
+			memcpy(&w2, &words[j][2 * W], sizeof(vtype)); \
+			memcpy(&w3, &words[j][3 * W], sizeof(vtype)); \
+			if (pos + 4 <= minlen) { \
+				STEP4(STEP, vtype, 0); \
+				STEP4(STEP, vtype, 1); \
+				STEP4(STEP, vtype, 2); \
+				STEP4(STEP, vtype, 3); \
+			} \
+			else { \
+				STEP4_MASKED(STEP, vtype, 0, pos + 0); \
+				STEP4_MASKED(STEP, vtype, 1, pos + 1); \
+				STEP4_MASKED(STEP, vtype, 2, pos + 2); \
+				STEP4_MASKED(STEP, vtype, 3, pos + 3); \
+			} \
+		} \
+	} \
+	\
+	FINAL(h0); FINAL(h1); FINAL(h2); FINAL(h3); \
+	memcpy(out + 0 * W, &h0, sizeof(vtype)); \
+	memcpy(out + 1 * W, &h1, sizeof(vtype)); \
+	memcpy(out + 2 * W, &h2, sizeof(vtype)); \
+	memcpy(out + 3 * W, &h3, sizeof(vtype)); \
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+#	define HAVE_SIMD_DISPATCH 1
+#	define TARGET_AVX2 __attribute__((target("avx2")))
+#	define TARGET_AVX512 __attribute__((target("avx512f")))
+#endif
+
+enum {
+	SIMD_UNKNOWN = 0,
+	SIMD_BASELINE,
+	SIMD_AVX2,
+	SIMD_AVX512,
+};
+
+static int simd_level(void) {
+	static int level = SIMD_UNKNOWN;
+	int l = __atomic_load_n(&level, __ATOMIC_RELAXED);
+
+	if (l == SIMD_UNKNOWN) {
+		l = SIMD_BASELINE;
+#ifdef HAVE_SIMD_DISPATCH
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx512f")) {
+			l = SIMD_AVX512;
+		}
+		else
+		if (__builtin_cpu_supports("avx2")) {
+			l = SIMD_AVX2;
+		}
+#endif
+		__atomic_store_n(&level, l, __ATOMIC_RELAXED);
+	}
+
+	return l;
+}
+
+/*
+ * Splits n keys into groups for the selected kernel. The last partial group
+ * and long keys go through the scalar hash_n, a long key leaves an empty
+ * lane behind in its group.
+ */
+static void hash_many(const char * const * keys, const size_t * lens, size_t n, uint32_t * out,
+	hash_n_fn hash_n, hash_group_fn group8, hash_group_fn group8_avx2, hash_group_fn group16_avx512) {
+
+	hash_group_fn group = group8;
+	unsigned int W = NV * 8;
+	uint32_t glens[MAX_LANES];
+	size_t i = 0;
+
+	switch (simd_level()) {
+		case SIMD_AVX512:
+			group = group16_avx512;
+			W = NV * 16;
+			break;
+		case SIMD_AVX2:
+			group = group8_avx2;
+			break;
+	}
+
+	for (; n - i >= W; i += W) {
+		unsigned int l;
+		bool scalar = false;
+		size_t len, total = 0;
+
+		/* prefetch the next group while this one is hashed */
+		if (n - i >= 2 * W) {
+			for (l = 0; l < W; ++l) {
+				__builtin_prefetch(keys[i + W + l]);
+			}
+		}
+
+		for (l = 0; l < W; ++l) {
+			len = lens ? lens[i + l] : strlen(keys[i + l]);
+			if (len > MAX_LANE_LEN) {
+				scalar = true;
+				len = 0;
+			}
+			glens[l] = (uint32_t)len;
+			total += len;
+		}
+
+		/* short keys are faster one at a time than transposed */
+		if (!scalar && total < W * MIN_LANE_AVG) {
+			for (l = 0; l < W; ++l) {
+				out[i + l] = hash_n(keys[i + l], glens[l]);
+			}
+			continue;
+		}
+
+		group(keys + i, glens, out + i);
+
+		if (scalar) {
+			for (l = 0; l < W; ++l) {
+				len = lens ? lens[i + l] : strlen(keys[i + l]);
+				if (len > MAX_LANE_LEN) {
+					out[i + l] = hash_n(keys[i + l], len);
+				}
+			}
+		}
+	}
+
+	for (; i < n; ++i) {
+		out[i] = hash_n(keys[i], lens ? lens[i] : strlen(keys[i]));
+	}
+}
+
+#ifdef HAVE_SIMD_DISPATCH
+#	define DEFINE_HASH_MANY(family, INIT, STEP, FINAL) \
+	DEFINE_HASH_GROUP(family##_group8, 8, vec8u, , INIT, STEP, FINAL) \
+	DEFINE_HASH_GROUP(family##_group8_avx2, 8, vec8u, TARGET_AVX2, INIT, STEP, FINAL) \
+	DEFINE_HASH_GROUP(family##_group16_avx512, 16, vec16u, TARGET_AVX512, INIT, STEP, FINAL) \
+	void family##_hash_many(const char * const * keys, const size_t * lens, size_t n, uint32_t * out) { \
+		hash_many(keys, lens, n, out, family##_hash_n, \
+			family##_group8, family##_group8_avx2, family##_group16_avx512); \
+	}
+#else
+#	define DEFINE_HASH_MANY(family, INIT, STEP, FINAL) \
+	DEFINE_HASH_GROUP(family##_group8, 8, vec8u, , INIT, STEP, FINAL) \
+	void family##_hash_many(const char * const * keys, const size_t * lens, size_t n, uint32_t * out) { \
+		hash_many(keys, lens, n, out, family##_hash_n, \
+			family##_group8, family##_group8, family##_group8); \
+	}
+#endif
+
+DEFINE_HASH_MANY(fnv1, 0x811c9dc5U, FNV1_STEP, NO_FINAL)
+DEFINE_HASH_MANY(fnv1a, 0x811c9dc5U, FNV1A_STEP, NO_FINAL)
+DEFINE_HASH_MANY(djb2, 5381U, DJB2_STEP, NO_FINAL)
+DEFINE_HASH_MANY(sdbm, 0U, SDBM_STEP, NO_FINAL)
+DEFINE_HASH_MANY(bkdr, 0U, BKDR_STEP, NO_FINAL)
+DEFINE_HASH_MANY(ly, 0U, LY_STEP, NO_FINAL)
+DEFINE_HASH_MANY(faq6, 0U, FAQ6_STEP, FAQ6_FINAL)
+
+/* vim: set ts=4 tw=78 noet: */
+
@@ -16,9 +16,58 @@
  *
  ****************************************************************************/
 
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
 #include "hashfns.h"
 
 
+/*****************************************************************************
+ * word-at-a-time helpers for length-aware variants
+ ****************************************************************************/
+
+static inline uint64_t load_word(const unsigned char * p) {
+	uint64_t w;
+	memcpy(&w, p, sizeof(w));
+	return w;
+}
+
+/* k-th byte of the loaded word in memory order */
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#	define WORD_BYTE(w, k) ((unsigned int)((w) >> (56 - 8 * (k))) & 0xFFU)
+#else
+#	define WORD_BYTE(w, k) ((unsigned int)((w) >> (8 * (k))) & 0xFFU)
+#endif
+
+/*
+ * Feeds len bytes at p to STEP one by one, byte value in c and its offset
+ * in i. The body loads 8 bytes per iteration, the tail is taken byte by
+ * byte, so nothing is ever read past p + len.
+ */
+#define FOREACH_BYTE_N(p, len, c, i, STEP) \
+	do { \
+		const unsigned char * bytes_ = (const unsigned char *)(p); \
+		const size_t len_ = (len); \
+		size_t i = 0; \
+		unsigned int c; \
+		while (len_ - i >= 8) { \
+			const uint64_t w_ = load_word(bytes_ + i); \
+			c = WORD_BYTE(w_, 0); STEP; ++i; \
+			c = WORD_BYTE(w_, 1); STEP; ++i; \
+			c = WORD_BYTE(w_, 2); STEP; ++i; \
+			c = WORD_BYTE(w_, 3); STEP; ++i; \
+			c = WORD_BYTE(w_, 4); STEP; ++i; \
+			c = WORD_BYTE(w_, 5); STEP; ++i; \
+			c = WORD_BYTE(w_, 6); STEP; ++i; \
+			c = WORD_BYTE(w_, 7); STEP; ++i; \
+		} \
+		for (; i < len_; ++i) { \
+			c = bytes_[i]; STEP; \
+		} \
+	} while (0)
+
+
 /*
  * http://www.cse.yorku.ca/~oz/hash.html
  * this algorithm (k=33) was first reported by dan bernstein many years ago
@@ -351,5 +400,926 @@ unsigned int my1_hash(const char * s) {
 	return hash;
 }
 
-/* vim: set ts=4 tw=78 noet: */
+/*****************************************************************************
+ * length-aware variants
+ *
+ * Each xxx_hash_n(p, len) gives the same value as xxx_hash(s) whenever
+ * len == strlen(s); embedded NULs are hashed as ordinary bytes.
+ ****************************************************************************/
+
+unsigned int djb2_hash_n(const void * p, size_t len) {
+	unsigned int hash = 5381;
+
+	FOREACH_BYTE_N(p, len, c, i, {
+		hash = ((hash << 5) + hash) + c;
+	});
+
+	return hash;
+}
+
+unsigned int sdbm_hash_n(const void * p, size_t len) {
+	unsigned int hash = 0;
+
+	FOREACH_BYTE_N(p, len, c, i, {
+		hash = c + (hash << 6) + (hash << 16) - hash;
+	});
+
+	return hash;
+}
+
+unsigned int lose_hash_n(const void * p, size_t len) {
+	unsigned int hash = 0;
+
+	FOREACH_BYTE_N(p, len, c, i, {
+		hash += c;
+	});
+
+	return hash;
+}
+
+unsigned int rs_hash_n(const void * p, size_t len) {
+	unsigned int b = 378551;
+	unsigned int a = 63689;
+	unsigned int hash = 0;
+
+	FOREACH_BYTE_N(p, len, c, i, {
+		hash = hash * a + c;
+		a = a * b;
+	});
+
+	return hash;
+}
+
+unsigned int js_hash_n(const void * p, size_t len) {
+	unsigned int hash = 1315423911;
+
+	FOREACH_BYTE_N(p, len, c, i, {
+		hash ^= ((hash << 5) + c + (hash >> 2));
+	});
+
+	return hash;
+}
+
+unsigned int pjw_hash_n(const void * p, size_t len) {
+	unsigned int hash = 0;
+	unsigned int test = 0;
+
+	FOREACH_BYTE_N(p, len, c, i, {
+		hash = (hash << 4) + c;
+		if ((test = hash & 0xF0000000U) != 0) {
+			hash = ((hash ^ (test >> 24)) & 0x0FFFFFFFU);
+		}
+	});
+
+	return hash;
+}
+
+unsigned int elf_hash_n(const void * p, size_t len) {
+	unsigned int hash = 0;
+	unsigned int x = 0;
+
+	FOREACH_BYTE_N(p, len, c, i, {
+		hash = (hash << 4) + c;
+		if ((x = hash & 0xF0000000U) != 0) {
+			hash ^= (x >> 24);
+			hash &= ~x;
+		}
+	});
+
+	return hash;
+}
+
+unsigned int bkdr_hash_n(const void * p, size_t len) {
+	unsigned int seed = 131313;   /* the same as in bkdr_hash() */
+	unsigned int hash = 0;
+
+	FOREACH_BYTE_N(p, len, c, i, {
+		hash = (hash * seed) + c;
+	});
+
+	return hash;
+}
+
+unsigned int mabkdr_hash_n(const void * p, size_t len) {
+	unsigned int seed = 131313;   /* the same as in mabkdr_hash() */
+	unsigned int hash = 0;
+
+	FOREACH_BYTE_N(p, len, c, i, {
+		hash = (hash * seed) + c + (unsigned int)i;
+	});
+
+	return hash;
+}
+
+unsigned int dek_hash_n(const void * p, size_t len) {
+	unsigned int hash = (unsigned int)len;
+
+	FOREACH_BYTE_N(p, len, c, i, {
+		hash = ((hash << 5) ^ (hash >> 27)) ^ c;
+	});
+
+	return hash;
+}
+
+unsigned int ap_hash_n(const void * p, size_t len) {
+	unsigned int hash = 0;
+
+	FOREACH_BYTE_N(p, len, c, i, {
+		hash ^= ((i & 1) == 0) ?
+			((hash << 7) ^ c ^ (hash >> 3)) :
+			(~((hash << 11) ^ c ^ (hash >> 5)));
+	});
+
+	return hash;
+}
+
+unsigned int ly_hash_n(const void * p, size_t len) {
+	unsigned int hash = 0;
+
+	FOREACH_BYTE_N(p, len, c, i, {
+		hash = (hash * 1664525) + c + 1013904223;
+	});
+
+	return hash;
+}
+
+unsigned int rot13_hash_n(const void * p, size_t len) {
+	unsigned int hash = 0;
+
+	/* rot13_hash() does not mask the byte, so keep plain char signedness */
+	FOREACH_BYTE_N(p, len, c, i, {
+		hash = (hash + (unsigned int)(char)c - (hash << 13)) | (hash >> 19);
+	});
+
+	return hash;
+}
+
+unsigned int faq6_hash_n(const void * p, size_t len) {
+	unsigned int hash = 0;
+
+	FOREACH_BYTE_N(p, len, c, i, {
+		hash += c;
+		hash += (hash << 10);
+		hash ^= (hash >> 6);
+	});
+	hash += (hash << 3);
+	hash ^= (hash >> 11);
+	hash += (hash << 15);
+	return hash;
+}
+
+unsigned int fnv1_hash_n(const void * p, size_t len) {
+	unsigned int hash = 0x811c9dc5;
+
+	FOREACH_BYTE_N(p, len, c, i, {
+		hash *= 0x01000193;
+		hash ^= c;
+	});
+
+	return hash;
+}
+
+unsigned int fnv1a_hash_n(const void * p, size_t len) {
+	unsigned int hash = 0x811c9dc5;
+
+	FOREACH_BYTE_N(p, len, c, i, {
+		hash ^= c;
+		hash *= 0x01000193;
+	});
+
+	return hash;
+}
+
+unsigned int q3cvars_hash_n(const void * p, size_t len) {
+	unsigned int hash = 0;
+
+	FOREACH_BYTE_N(p, len, c, i, {
+		if (c >= 'A' && c <= 'Z') {
+			c = c - 'A' + 'a';
+		}
+		hash += c * ((unsigned int)i + 119);
+	});
+
+	return hash;
+}
+
+unsigned int my1_hash_n(const void * p, size_t len) {
+	unsigned int hash = 0;
+
+	FOREACH_BYTE_N(p, len, c, i, {
+		if (c > 'A' && c < 'Z') {
+			hash += c - 'A';
+			hash += (hash << 10);
+			hash ^= (hash >> 6);
+		}
+		else
+		if (c > 'a' && c < 'z') {
+			hash += c - 'a';
+			hash += (hash << 10);
+			hash ^= (hash >> 6);
+		}
+	});
+
+	hash += (hash << 3);
+	hash ^= (hash >> 11);
+	hash += (hash << 15);
+
+	return hash;
+}
+
+/*****************************************************************************
+ * 64-bit variants
+ *
+ * The same recurrences computed in 64-bit arithmetic; FNV uses its 64-bit
+ * offset basis and prime, http://www.isthe.com/chongo/tech/comp/fnv/
+ ****************************************************************************/
+
+#define FNV64_OFFSET_BASIS 0xcbf29ce484222325ULL
+#define FNV64_PRIME 0x00000100000001b3ULL
+
+uint64_t djb2_hash64(const char * s) {
+	uint64_t hash = 5381;
+	unsigned int c;
+
+	while ((c = (unsigned char)*s++)) {
+		hash = ((hash << 5) + hash) + c;
+	}
+
+	return hash;
+}
+
+uint64_t sdbm_hash64(const char * s) {
+	uint64_t hash = 0;
+	unsigned int c;
+
+	while ((c = (unsigned char)*s++)) {
+		hash = c + (hash << 6) + (hash << 16) - hash;
+	}
+
+	return hash;
+}
+
+uint64_t bkdr_hash64(const char * s) {
+	uint64_t seed = 131313;
+	uint64_t hash = 0;
+	unsigned int c;
+
+	while ((c = (unsigned char)*s++)) {
+		hash = (hash * seed) + c;
+	}
+
+	return hash;
+}
+
+uint64_t fnv1_hash64(const char * s) {
+	uint64_t hash = FNV64_OFFSET_BASIS;
+	unsigned int c;
+
+	while ((c = (unsigned char)*s++)) {
+		hash *= FNV64_PRIME;
+		hash ^= c;
+	}
+
+	return hash;
+}
+
+uint64_t fnv1a_hash64(const char * s) {
+	uint64_t hash = FNV64_OFFSET_BASIS;
+	unsigned int c;
+
+	while ((c = (unsigned char)*s++)) {
+		hash ^= c;
+		hash *= FNV64_PRIME;
+	}
+
+	return hash;
+}
+
+uint64_t djb2_hash64_n(const void * p, size_t len) {
+	uint64_t hash = 5381;
+
+	FOREACH_BYTE_N(p, len, c, i, {
+		hash = ((hash << 5) + hash) + c;
+	});
+
+	return hash;
+}
+
+uint64_t sdbm_hash64_n(const void * p, size_t len) {
+	uint64_t hash = 0;
+
+	FOREACH_BYTE_N(p, len, c, i, {
+		hash = c + (hash << 6) + (hash << 16) - hash;
+	});
+
+	return hash;
+}
+
+uint64_t bkdr_hash64_n(const void * p, size_t len) {
+	uint64_t seed = 131313;
+	uint64_t hash = 0;
+
+	FOREACH_BYTE_N(p, len, c, i, {
+		hash = (hash * seed) + c;
+	});
+
+	return hash;
+}
+
+uint64_t fnv1_hash64_n(const void * p, size_t len) {
+	uint64_t hash = FNV64_OFFSET_BASIS;
+
+	FOREACH_BYTE_N(p, len, c, i, {
+		hash *= FNV64_PRIME;
+		hash ^= c;
+	});
+
+	return hash;
+}
+
+uint64_t fnv1a_hash64_n(const void * p, size_t len) {
+	uint64_t hash = FNV64_OFFSET_BASIS;
+
+	FOREACH_BYTE_N(p, len, c, i, {
+		hash ^= c;
+		hash *= FNV64_PRIME;
+	});
+
+	return hash;
+}
+
+
+/*****************************************************************************
+ * block hashes for long keys
+ *
+ * These consume 4 to 48 bytes per step, and all input is read as little
+ * endian words, so every platform computes the same values as the
+ * reference implementations with seed 0.
+ ****************************************************************************/
+
+static inline uint32_t read32le(const unsigned char * p) {
+	uint32_t v;
+	memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+	v = __builtin_bswap32(v);
+#endif
+	return v;
+}
+
+static inline uint64_t read64le(const unsigned char * p) {
+	uint64_t v;
+	memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+	v = __builtin_bswap64(v);
+#endif
+	return v;
+}
+
+static inline uint32_t rotl32(uint32_t x, unsigned int r) {
+	return (x << r) | (x >> (32 - r));
+}
+
+static inline uint64_t rotl64(uint64_t x, unsigned int r) {
+	return (x << r) | (x >> (64 - r));
+}
+
+/*
+ * xxHash32, https://github.com/Cyan4973/xxHash/blob/dev/doc/xxhash_spec.md
+ * four independent accumulators take 16 bytes per step.
+ */
+#define XXH32_PRIME1 0x9E3779B1U
+#define XXH32_PRIME2 0x85EBCA77U
+#define XXH32_PRIME3 0xC2B2AE3DU
+#define XXH32_PRIME4 0x27D4EB2FU
+#define XXH32_PRIME5 0x165667B1U
+
+static inline uint32_t xxh32_round(uint32_t acc, uint32_t lane) {
+	return rotl32(acc + lane * XXH32_PRIME2, 13) * XXH32_PRIME1;
+}
+
+static uint32_t xxh32_seeded(const void * p, size_t len, uint32_t seed) {
+	const unsigned char * b = (const unsigned char *)p;
+	const unsigned char * const end = b + len;
+	uint32_t hash;
+
+	if (len >= 16) {
+		uint32_t v1 = seed + XXH32_PRIME1 + XXH32_PRIME2;
+		uint32_t v2 = seed + XXH32_PRIME2;
+		uint32_t v3 = seed;
+		uint32_t v4 = seed - XXH32_PRIME1;
+		do {
+			v1 = xxh32_round(v1, read32le(b));
+			v2 = xxh32_round(v2, read32le(b + 4));
+			v3 = xxh32_round(v3, read32le(b + 8));
+			v4 = xxh32_round(v4, read32le(b + 12));
+			b += 16;
+		} while (end - b >= 16);
+		hash = rotl32(v1, 1) + rotl32(v2, 7) + rotl32(v3, 12) + rotl32(v4, 18);
+	}
+	else {
+		hash = seed + XXH32_PRIME5;
+	}
+
+	hash += (uint32_t)len;
+	for (; end - b >= 4; b += 4) {
+		hash = rotl32(hash + read32le(b) * XXH32_PRIME3, 17) * XXH32_PRIME4;
+	}
+	for (; b < end; ++b) {
+		hash = rotl32(hash + *b * XXH32_PRIME5, 11) * XXH32_PRIME1;
+	}
+
+	hash ^= hash >> 15;
+	hash *= XXH32_PRIME2;
+	hash ^= hash >> 13;
+	hash *= XXH32_PRIME3;
+	hash ^= hash >> 16;
+	return hash;
+}
+
+unsigned int xxh32_hash_n(const void * p, size_t len) {
+	return xxh32_seeded(p, len, 0);
+}
+
+unsigned int xxh32_hash(const char * s) {
+	return xxh32_hash_n(s, strlen(s));
+}
+
+/*
+ * xxHash64, https://github.com/Cyan4973/xxHash/blob/dev/doc/xxhash_spec.md
+ * four independent accumulators take 32 bytes per step.
+ */
+#define XXH64_PRIME1 0x9E3779B185EBCA87ULL
+#define XXH64_PRIME2 0xC2B2AE3D27D4EB4FULL
+#define XXH64_PRIME3 0x165667B19E3779F9ULL
+#define XXH64_PRIME4 0x85EBCA77C2B2AE63ULL
+#define XXH64_PRIME5 0x27D4EB2F165667C5ULL
+
+static inline uint64_t xxh64_round(uint64_t acc, uint64_t lane) {
+	return rotl64(acc + lane * XXH64_PRIME2, 31) * XXH64_PRIME1;
+}
+
+static inline uint64_t xxh64_merge(uint64_t hash, uint64_t acc) {
+	return (hash ^ xxh64_round(0, acc)) * XXH64_PRIME1 + XXH64_PRIME4;
+}
+
+uint64_t xxh64_hash_n(const void * p, size_t len) {
+	const unsigned char * b = (const unsigned char *)p;
+	const unsigned char * const end = b + len;
+	uint64_t hash;
+
+	if (len >= 32) {
+		uint64_t v1 = XXH64_PRIME1 + XXH64_PRIME2;
+		uint64_t v2 = XXH64_PRIME2;
+		uint64_t v3 = 0;
+		uint64_t v4 = 0 - XXH64_PRIME1;
+		do {
+			v1 = xxh64_round(v1, read64le(b));
+			v2 = xxh64_round(v2, read64le(b + 8));
+			v3 = xxh64_round(v3, read64le(b + 16));
+			v4 = xxh64_round(v4, read64le(b + 24));
+			b += 32;
+		} while (end - b >= 32);
+		hash = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+		hash = xxh64_merge(hash, v1);
+		hash = xxh64_merge(hash, v2);
+		hash = xxh64_merge(hash, v3);
+		hash = xxh64_merge(hash, v4);
+	}
+	else {
+		hash = XXH64_PRIME5;
+	}
+
+	hash += (uint64_t)len;
+	for (; end - b >= 8; b += 8) {
+		hash ^= xxh64_round(0, read64le(b));
+		hash = rotl64(hash, 27) * XXH64_PRIME1 + XXH64_PRIME4;
+	}
+	if (end - b >= 4) {
+		hash ^= (uint64_t)read32le(b) * XXH64_PRIME1;
+		hash = rotl64(hash, 23) * XXH64_PRIME2 + XXH64_PRIME3;
+		b += 4;
+	}
+	for (; b < end; ++b) {
+		hash ^= *b * XXH64_PRIME5;
+		hash = rotl64(hash, 11) * XXH64_PRIME1;
+	}
+
+	hash ^= hash >> 33;
+	hash *= XXH64_PRIME2;
+	hash ^= hash >> 29;
+	hash *= XXH64_PRIME3;
+	hash ^= hash >> 32;
+	return hash;
+}
+
+uint64_t xxh64_hash(const char * s) {
+	return xxh64_hash_n(s, strlen(s));
+}
+
+/*
+ * MurmurHash3_x86_32 by Austin Appleby,
+ * https://github.com/aappleby/smhasher/blob/master/src/MurmurHash3.cpp
+ */
+static uint32_t murmur3_seeded(const void * p, size_t len, uint32_t seed) {
+	const unsigned char * b = (const unsigned char *)p;
+	const uint32_t c1 = 0xcc9e2d51U;
+	const uint32_t c2 = 0x1b873593U;
+	uint32_t hash = seed;
+	uint32_t k;
+	size_t i;
+
+	for (i = 0; len - i >= 4; i += 4) {
+		k = read32le(b + i) * c1;
+		k = rotl32(k, 15) * c2;
+		hash ^= k;
+		hash = rotl32(hash, 13) * 5 + 0xe6546b64U;
+	}
+
+	k = 0;
+	switch (len & 3) {
+		case 3:
+			k ^= (uint32_t)b[i + 2] << 16;
+			/* fall through */
+		case 2:
+			k ^= (uint32_t)b[i + 1] << 8;
+			/* fall through */
+		case 1:
+			k ^= b[i];
+			k = rotl32(k * c1, 15) * c2;
+			hash ^= k;
+	}
+
+	hash ^= (uint32_t)len;
+	hash ^= hash >> 16;
+	hash *= 0x85ebca6bU;
+	hash ^= hash >> 13;
+	hash *= 0xc2b2ae35U;
+	hash ^= hash >> 16;
+	return hash;
+}
+
+unsigned int murmur3_hash_n(const void * p, size_t len) {
+	return murmur3_seeded(p, len, 0);
+}
+
+unsigned int murmur3_hash(const char * s) {
+	return murmur3_hash_n(s, strlen(s));
+}
+
+/*
+ * wyhash final version 4 by Wang Yi with its default secret,
+ * https://github.com/wangyi-fudan/wyhash
+ * three independent lanes take 48 bytes per step.
+ */
+static const uint64_t wyp[4] = {
+	0x2d358dccaa6c78a5ULL, 0x8bb84b93962eacc9ULL,
+	0x4b33a62ed433d4a3ULL, 0x4d5a2da51de1aa47ULL
+};
+
+static inline void wymum(uint64_t * a, uint64_t * b) {
+#ifdef __SIZEOF_INT128__
+	unsigned __int128 r = (unsigned __int128)*a * *b;
+	*a = (uint64_t)r;
+	*b = (uint64_t)(r >> 64);
+#else
+	uint64_t ha = *a >> 32, hb = *b >> 32, la = (uint32_t)*a, lb = (uint32_t)*b;
+	uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+	uint64_t t = rl + (rm0 << 32), c = t < rl;
+	uint64_t lo = t + (rm1 << 32);
+	c += lo < t;
+	*a = lo;
+	*b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+
+static inline uint64_t wymix(uint64_t a, uint64_t b) {
+	wymum(&a, &b);
+	return a ^ b;
+}
+
+static inline uint64_t wyr3(const unsigned char * p, size_t k) {
+	return ((uint64_t)p[0] << 16) | ((uint64_t)p[k >> 1] << 8) | p[k - 1];
+}
+
+uint64_t wy_hash_n(const void * p, size_t len) {
+	const unsigned char * b = (const unsigned char *)p;
+	uint64_t seed = wymix(wyp[0], wyp[1]);
+	uint64_t x, y;
+
+	if (len <= 16) {
+		if (len >= 4) {
+			x = ((uint64_t)read32le(b) << 32) | read32le(b + ((len >> 3) << 2));
+			y = ((uint64_t)read32le(b + len - 4) << 32) | read32le(b + len - 4 - ((len >> 3) << 2));
+		}
+		else
+		if (len > 0) {
+			x = wyr3(b, len);
+			y = 0;
+		}
+		else {
+			x = y = 0;
+		}
+	}
+	else {
+		size_t i = len;
+		if (i > 48) {
+			uint64_t see1 = seed, see2 = seed;
+			do {
+				seed = wymix(read64le(b) ^ wyp[1], read64le(b + 8) ^ seed);
+				see1 = wymix(read64le(b + 16) ^ wyp[2], read64le(b + 24) ^ see1);
+				see2 = wymix(read64le(b + 32) ^ wyp[3], read64le(b + 40) ^ see2);
+				b += 48;
+				i -= 48;
+			} while (i > 48);
+			seed ^= see1 ^ see2;
+		}
+		while (i > 16) {
+			seed = wymix(read64le(b) ^ wyp[1], read64le(b + 8) ^ seed);
+			b += 16;
+			i -= 16;
+		}
+		x = read64le(b + i - 16);
+		y = read64le(b + i - 8);
+	}
+
+	x ^= wyp[1];
+	y ^= seed;
+	wymum(&x, &y);
+	return wymix(x ^ wyp[0] ^ len, y ^ wyp[1]);
+}
+
+uint64_t wy_hash(const char * s) {
+	return wy_hash_n(s, strlen(s));
+}
+
+/*****************************************************************************
+ * CRC-32C (Castagnoli)
+ *
+ * The portable code is slicing-by-8 over tables built on first use. On
+ * x86-64 a GNU ifunc resolver picks the SSE4.2 crc32 instruction instead:
+ * 8 bytes per instruction, three independent streams over long inputs,
+ * recombined with a carry-less multiply. The plugin compiles this file as
+ * C++ without the ifunc, so it folds calls with the portable code, which
+ * computes the same values.
+ ****************************************************************************/
+
+#define CRC32C_POLY 0x82F63B78U
+
+static uint32_t crc32c_table[8][256];
+static int crc32c_table_state;
+
+enum {
+	CRC32C_TABLE_NONE = 0,
+	CRC32C_TABLE_BUILDING,
+	CRC32C_TABLE_READY,
+};
+
+/* the first caller builds the tables, the others go bitwise meanwhile */
+static bool crc32c_table_ready(void) {
+	int state = __atomic_load_n(&crc32c_table_state, __ATOMIC_ACQUIRE);
+	if (CRC32C_TABLE_READY == state) {
+		return true;
+	}
+	if (CRC32C_TABLE_NONE != state ||
+		!__atomic_compare_exchange_n(&crc32c_table_state, &state, CRC32C_TABLE_BUILDING,
+			false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+		return false;
+	}
+
+	for (unsigned int n = 0; n < 256; ++n) {
+		uint32_t crc = n;
+		for (int k = 0; k < 8; ++k) {
+			crc = (crc >> 1) ^ (CRC32C_POLY & (0U - (crc & 1)));
+		}
+		crc32c_table[0][n] = crc;
+	}
+	for (unsigned int n = 0; n < 256; ++n) {
+		uint32_t crc = crc32c_table[0][n];
+		for (int k = 1; k < 8; ++k) {
+			crc = crc32c_table[0][crc & 0xff] ^ (crc >> 8);
+			crc32c_table[k][n] = crc;
+		}
+	}
+
+	__atomic_store_n(&crc32c_table_state, CRC32C_TABLE_READY, __ATOMIC_RELEASE);
+	return true;
+}
+
+static uint32_t crc32c_sw(uint32_t crc, const unsigned char * b, size_t len) {
+	if (!crc32c_table_ready()) {
+		while (len--) {
+			crc ^= *b++;
+			for (int k = 0; k < 8; ++k) {
+				crc = (crc >> 1) ^ (CRC32C_POLY & (0U - (crc & 1)));
+			}
+		}
+		return crc;
+	}
+
+	for (; len >= 8; b += 8, len -= 8) {
+		uint32_t lo = read32le(b) ^ crc;
+		uint32_t hi = read32le(b + 4);
+		crc = crc32c_table[7][lo & 0xff] ^ crc32c_table[6][(lo >> 8) & 0xff] ^
+			crc32c_table[5][(lo >> 16) & 0xff] ^ crc32c_table[4][lo >> 24] ^
+			crc32c_table[3][hi & 0xff] ^ crc32c_table[2][(hi >> 8) & 0xff] ^
+			crc32c_table[1][(hi >> 16) & 0xff] ^ crc32c_table[0][hi >> 24];
+	}
+	while (len--) {
+		crc = crc32c_table[0][(crc ^ *b++) & 0xff] ^ (crc >> 8);
+	}
+	return crc;
+}
+
+#if defined(__x86_64__) && defined(__ELF__) && !defined(__cplusplus)
+#	define HAVE_CRC32C_IFUNC 1
+#endif
+
+#ifdef HAVE_CRC32C_IFUNC
+
+#define TARGET_CRC32C __attribute__((target("sse4.2,pclmul")))
+
+/* block sizes of the long and short interleave, and x^(8 * block) mod P */
+#define CRC32C_LONG 2048
+#define CRC32C_LONG_SHIFT 0x0d65762aU
+#define CRC32C_SHORT 128
+#define CRC32C_SHORT_SHIFT 0xb8fdb1e7U
+
+typedef long long crc32c_v2di __attribute__((vector_size(16)));
+
+/* crc * x^(8 * block) mod P: a carry-less product reduced by crc32 */
+TARGET_CRC32C static inline uint32_t crc32c_shift(uint32_t crc, uint32_t k) {
+	crc32c_v2di a = { crc, 0 };
+	crc32c_v2di b = { k, 0 };
+	crc32c_v2di p = __builtin_ia32_pclmulqdq128(a, b, 0x00);
+	uint64_t v = (uint64_t)p[0] << 1;
+	return __builtin_ia32_crc32si(0, (uint32_t)v) ^ (uint32_t)(v >> 32);
+}
+
+TARGET_CRC32C static inline uint32_t crc32c_hw_blocks(uint32_t crc,
+	const unsigned char ** pb, size_t * plen, size_t block, uint32_t shift) {
+
+	const unsigned char * b = *pb;
+	size_t len = *plen;
+
+	for (; len >= 3 * block; b += 3 * block, len -= 3 * block) {
+		uint64_t c0 = crc, c1 = 0, c2 = 0;
+		for (size_t i = 0; i < block; i += 8) {
+			c0 = __builtin_ia32_crc32di(c0, read64le(b + i));
+			c1 = __builtin_ia32_crc32di(c1, read64le(b + block + i));
+			c2 = __builtin_ia32_crc32di(c2, read64le(b + 2 * block + i));
+		}
+		crc = crc32c_shift(crc32c_shift((uint32_t)c0, shift) ^ (uint32_t)c1, shift) ^ (uint32_t)c2;
+	}
+
+	*pb = b;
+	*plen = len;
+	return crc;
+}
+
+TARGET_CRC32C static uint32_t crc32c_hw(uint32_t crc, const unsigned char * b, size_t len) {
+	crc = crc32c_hw_blocks(crc, &b, &len, CRC32C_LONG, CRC32C_LONG_SHIFT);
+	crc = crc32c_hw_blocks(crc, &b, &len, CRC32C_SHORT, CRC32C_SHORT_SHIFT);
+
+	uint64_t c = crc;
+	for (; len >= 8; b += 8, len -= 8) {
+		c = __builtin_ia32_crc32di(c, read64le(b));
+	}
+	crc = (uint32_t)c;
+	while (len--) {
+		crc = __builtin_ia32_crc32qi(crc, *b++);
+	}
+	return crc;
+}
+
+typedef uint32_t (* crc32c_fn)(uint32_t, const unsigned char *, size_t);
+
+static crc32c_fn crc32c_resolve(void) {
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("pclmul")) {
+		return crc32c_hw;
+	}
+	return crc32c_sw;
+}
+
+static uint32_t crc32c_update(uint32_t crc, const unsigned char * b, size_t len)
+	__attribute__((ifunc("crc32c_resolve")));
+
+#else
+#	define crc32c_update crc32c_sw
+#endif /* #ifdef HAVE_CRC32C_IFUNC */
+
+unsigned int crc32c_hash_n(const void * p, size_t len) {
+	return ~crc32c_update(~0U, (const unsigned char *)p, len);
+}
+
+unsigned int crc32c_hash(const char * s) {
+	return crc32c_hash_n(s, strlen(s));
+}
+
+/*****************************************************************************
+ * seeded variants
+ *
+ * Only hashes whose collisions depend on the seed are offered: with a
+ * multiply-add recurrence like djb2 or fnv, strings of the same length
+ * collide under every seed, so seeding them does not resist flooding.
+ ****************************************************************************/
+
+#ifndef STRHASH_SEED
+#	define STRHASH_SEED 0
+#endif
+
+uint32_t strhash_seed(void) {
+	return STRHASH_SEED;
+}
+
+unsigned int xxh32_hash_seeded(const char * s, uint32_t seed) {
+	return xxh32_seeded(s, strlen(s), seed);
+}
+
+unsigned int murmur3_hash_seeded(const char * s, uint32_t seed) {
+	return murmur3_seeded(s, strlen(s), seed);
+}
+
+/*****************************************************************************
+ * streaming variants
+ *
+ * xxx_final(xxx_update(xxx_init(), p, len)) == xxx_hash_n(p, len), and the
+ * input may be split between any number of updates. The whole state is
+ * the returned 32-bit value, so a state is copied by assignment.
+ ****************************************************************************/
+
+#define DEFINE_HASH_STREAM(name, INIT, STEP, FINAL) \
+uint32_t name##_init(void) { \
+	return INIT; \
+} \
+\
+uint32_t name##_update(uint32_t hash, const void * p, size_t len) { \
+	FOREACH_BYTE_N(p, len, c, i, STEP); \
+	return hash; \
+} \
+\
+unsigned int name##_final(uint32_t hash) { \
+	FINAL; \
+	return hash; \
+}
+
+DEFINE_HASH_STREAM(djb2, 5381, {
+	hash = ((hash << 5) + hash) + c;
+}, {})
+
+DEFINE_HASH_STREAM(sdbm, 0, {
+	hash = c + (hash << 6) + (hash << 16) - hash;
+}, {})
+
+DEFINE_HASH_STREAM(js, 1315423911, {
+	hash ^= ((hash << 5) + c + (hash >> 2));
+}, {})
+
+DEFINE_HASH_STREAM(pjw, 0, {
+	hash = (hash << 4) + c;
+	const uint32_t test = hash & 0xF0000000U;
+	if (test) {
+		hash = ((hash ^ (test >> 24)) & 0x0FFFFFFFU);
+	}
+}, {})
+
+DEFINE_HASH_STREAM(elf, 0, {
+	hash = (hash << 4) + c;
+	const uint32_t x = hash & 0xF0000000U;
+	if (x) {
+		hash ^= (x >> 24);
+		hash &= ~x;
+	}
+}, {})
+
+DEFINE_HASH_STREAM(bkdr, 0, {
+	hash = (hash * 131313) + c;
+}, {})
 
+DEFINE_HASH_STREAM(ly, 0, {
+	hash = (hash * 1664525) + c + 1013904223;
+}, {})
+
+DEFINE_HASH_STREAM(faq6, 0, {
+	hash += c;
+	hash += (hash << 10);
+	hash ^= (hash >> 6);
+}, {
+	hash += (hash << 3);
+	hash ^= (hash >> 11);
+	hash += (hash << 15);
+})
+
+DEFINE_HASH_STREAM(fnv1, 0x811c9dc5, {
+	hash *= 0x01000193;
+	hash ^= c;
+}, {})
+
+DEFINE_HASH_STREAM(fnv1a, 0x811c9dc5, {
+	hash ^= c;
+	hash *= 0x01000193;
+}, {})
+
+#undef DEFINE_HASH_STREAM
+
+/* vim: set ts=4 tw=78 noet: */
@@ -19,6 +19,9 @@
 #ifndef HASHFNS_H
 #define HASHFNS_H
 
+#include <stddef.h>
+#include <stdint.h>
+
 #ifdef __cpluplus
 extern "C" {
 #endif
@@ -42,6 +45,135 @@ unsigned int fnv1a_hash(const char * s);
 unsigned int q3cvars_hash(const char * s);
 unsigned int my1_hash(const char * s);
 
+/* length-aware variants: hash exactly len bytes at p, NUL is not special */
+unsigned int djb2_hash_n(const void * p, size_t len);
+unsigned int sdbm_hash_n(const void * p, size_t len);
+unsigned int lose_hash_n(const void * p, size_t len);
+unsigned int rs_hash_n(const void * p, size_t len);
+unsigned int js_hash_n(const void * p, size_t len);
+unsigned int pjw_hash_n(const void * p, size_t len);
+unsigned int elf_hash_n(const void * p, size_t len);
+unsigned int bkdr_hash_n(const void * p, size_t len);
+unsigned int mabkdr_hash_n(const void * p, size_t len);
+unsigned int dek_hash_n(const void * p, size_t len);
+unsigned int ap_hash_n(const void * p, size_t len);
+unsigned int ly_hash_n(const void * p, size_t len);
+unsigned int rot13_hash_n(const void * p, size_t len);
+unsigned int faq6_hash_n(const void * p, size_t len);
+unsigned int fnv1_hash_n(const void * p, size_t len);
+unsigned int fnv1a_hash_n(const void * p, size_t len);
+unsigned int q3cvars_hash_n(const void * p, size_t len);
+unsigned int my1_hash_n(const void * p, size_t len);
+
+/* 64-bit variants for large tables */
+uint64_t djb2_hash64(const char * s);
+uint64_t sdbm_hash64(const char * s);
+uint64_t bkdr_hash64(const char * s);
+uint64_t fnv1_hash64(const char * s);
+uint64_t fnv1a_hash64(const char * s);
+
+uint64_t djb2_hash64_n(const void * p, size_t len);
+uint64_t sdbm_hash64_n(const void * p, size_t len);
+uint64_t bkdr_hash64_n(const void * p, size_t len);
+uint64_t fnv1_hash64_n(const void * p, size_t len);
+uint64_t fnv1a_hash64_n(const void * p, size_t len);
+
+/* block hashes for long keys: xxHash32/64, MurmurHash3_x86_32, wyhash */
+unsigned int xxh32_hash(const char * s);
+uint64_t xxh64_hash(const char * s);
+unsigned int murmur3_hash(const char * s);
+uint64_t wy_hash(const char * s);
+
+unsigned int xxh32_hash_n(const void * p, size_t len);
+uint64_t xxh64_hash_n(const void * p, size_t len);
+unsigned int murmur3_hash_n(const void * p, size_t len);
+uint64_t wy_hash_n(const void * p, size_t len);
+
+/* CRC-32C, with the SSE4.2 crc32 instruction where the CPU has it */
+unsigned int crc32c_hash(const char * s);
+unsigned int crc32c_hash_n(const void * p, size_t len);
+
+/*
+ * seeded variants: strhash_seed() returns STRHASH_SEED which hashfns.c is
+ * compiled with, give the plugin the same value as seed= to fold it.
+ */
+uint32_t strhash_seed(void);
+unsigned int xxh32_hash_seeded(const char * s, uint32_t seed);
+unsigned int murmur3_hash_seeded(const char * s, uint32_t seed);
+
+/*
+ * streaming variants: xxx_final(xxx_update(xxx_init(), p, len)) equals
+ * xxx_hash_n(p, len), the data may be split between any number of updates.
+ */
+uint32_t djb2_init(void);
+uint32_t djb2_update(uint32_t state, const void * p, size_t len);
+unsigned int djb2_final(uint32_t state);
+
+uint32_t sdbm_init(void);
+uint32_t sdbm_update(uint32_t state, const void * p, size_t len);
+unsigned int sdbm_final(uint32_t state);
+
+uint32_t js_init(void);
+uint32_t js_update(uint32_t state, const void * p, size_t len);
+unsigned int js_final(uint32_t state);
+
+uint32_t pjw_init(void);
+uint32_t pjw_update(uint32_t state, const void * p, size_t len);
+unsigned int pjw_final(uint32_t state);
+
+uint32_t elf_init(void);
+uint32_t elf_update(uint32_t state, const void * p, size_t len);
+unsigned int elf_final(uint32_t state);
+
+uint32_t bkdr_init(void);
+uint32_t bkdr_update(uint32_t state, const void * p, size_t len);
+unsigned int bkdr_final(uint32_t state);
+
+uint32_t ly_init(void);
+uint32_t ly_update(uint32_t state, const void * p, size_t len);
+unsigned int ly_final(uint32_t state);
+
+uint32_t faq6_init(void);
+uint32_t faq6_update(uint32_t state, const void * p, size_t len);
+unsigned int faq6_final(uint32_t state);
+
+uint32_t fnv1_init(void);
+uint32_t fnv1_update(uint32_t state, const void * p, size_t len);
+unsigned int fnv1_final(uint32_t state);
+
+uint32_t fnv1a_init(void);
+uint32_t fnv1a_update(uint32_t state, const void * p, size_t len);
+unsigned int fnv1a_final(uint32_t state);
+
+/*
+ * batch variants: out[i] = xxx_hash_n(keys[i], lens[i]) for i < n, or
+ * xxx_hash(keys[i]) when lens is NULL; keys are hashed in SIMD lanes.
+ */
+void fnv1_hash_many(const char * const * keys, const size_t * lens, size_t n, uint32_t * out);
+void fnv1a_hash_many(const char * const * keys, const size_t * lens, size_t n, uint32_t * out);
+void djb2_hash_many(const char * const * keys, const size_t * lens, size_t n, uint32_t * out);
+void sdbm_hash_many(const char * const * keys, const size_t * lens, size_t n, uint32_t * out);
+void bkdr_hash_many(const char * const * keys, const size_t * lens, size_t n, uint32_t * out);
+void ly_hash_many(const char * const * keys, const size_t * lens, size_t n, uint32_t * out);
+void faq6_hash_many(const char * const * keys, const size_t * lens, size_t n, uint32_t * out);
+
+/*
+ * STRHASH_CONST(fn, "literal", ...) is an integer constant expression when
+ * the strhash plugin is loaded, usable in case labels and static
+ * initializers, and a plain fn call otherwise. Compilers without
+ * __has_builtin() need STRHASH_BUILTINS defined to get the constant.
+ */
+#if defined(STRHASH_BUILTINS)
+#	define STRHASH_CONST(fn, ...) __builtin_strhash_##fn(__VA_ARGS__)
+#elif defined(__has_builtin)
+#	if __has_builtin(__builtin_strhash_fnv1a_hash)
+#		define STRHASH_CONST(fn, ...) __builtin_strhash_##fn(__VA_ARGS__)
+#	endif
+#endif
+#ifndef STRHASH_CONST
+#	define STRHASH_CONST(fn, ...) fn(__VA_ARGS__)
+#endif
+
 #ifdef __cpluplus
 }
 #endif
@@ -0,0 +1,732 @@
+/*****************************************************************************
+ * Copyright (C) 2020 Alexander Potylitsin <apotyn@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ *
+ ****************************************************************************/
+
+/*
+ * constexpr twin of hashfns.c for C++14 and later, no plugin needed:
+ *
+ *   switch (strhash::fnv1a_hash(s)) {
+ *       case "if"_fnv1a: ...
+ *   }
+ *
+ * Every function of hashfns.h taking a string is here under the same name
+ * in namespace strhash, templated on the byte type, and gives the same
+ * value. Literals hash their whole length like xxx_hash_n(), the suffix is
+ * the name without _hash, so fnv1a_hash64 is _fnv1a_64; they are consteval
+ * with C++20. "make check" compares everything to hashfns.c and to the
+ * plugin on a generated corpus.
+ */
+
+#ifndef HASHFNS_HPP
+#define HASHFNS_HPP
+
+#if __cplusplus < 201402L
+#	error "hashfns.hpp needs C++14"
+#endif
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__cpp_consteval)
+#	define STRHASH_CONSTEVAL consteval
+#else
+#	define STRHASH_CONSTEVAL constexpr
+#endif
+
+namespace strhash {
+
+namespace detail {
+
+template <typename Char>
+constexpr unsigned int byte(Char c) {
+	static_assert(sizeof(Char) == 1, "hashes take strings of bytes");
+	return static_cast<unsigned char>(c);
+}
+
+template <typename Char>
+constexpr std::size_t length(const Char * s) {
+	std::size_t n = 0;
+	while (s[n]) ++n;
+	return n;
+}
+
+/* words are read as little endian, like hashfns.c does */
+template <typename Char>
+constexpr std::uint32_t read32le(const Char * p) {
+	return byte(p[0]) | byte(p[1]) << 8 | byte(p[2]) << 16 | static_cast<std::uint32_t>(byte(p[3])) << 24;
+}
+
+template <typename Char>
+constexpr std::uint64_t read64le(const Char * p) {
+	return read32le(p) | static_cast<std::uint64_t>(read32le(p + 4)) << 32;
+}
+
+constexpr std::uint32_t rotl32(std::uint32_t x, unsigned int r) {
+	return (x << r) | (x >> (32 - r));
+}
+
+constexpr std::uint64_t rotl64(std::uint64_t x, unsigned int r) {
+	return (x << r) | (x >> (64 - r));
+}
+
+} /* namespace detail */
+
+
+/*****************************************************************************
+ * byte at a time hashes
+ ****************************************************************************/
+
+template <typename Char>
+constexpr unsigned int djb2_hash_n(const Char * p, std::size_t len) {
+	std::uint32_t hash = 5381;
+	for (std::size_t i = 0; i < len; ++i) {
+		hash = ((hash << 5) + hash) + detail::byte(p[i]);
+	}
+	return hash;
+}
+
+template <typename Char>
+constexpr unsigned int sdbm_hash_n(const Char * p, std::size_t len) {
+	std::uint32_t hash = 0;
+	for (std::size_t i = 0; i < len; ++i) {
+		hash = detail::byte(p[i]) + (hash << 6) + (hash << 16) - hash;
+	}
+	return hash;
+}
+
+template <typename Char>
+constexpr unsigned int lose_hash_n(const Char * p, std::size_t len) {
+	std::uint32_t hash = 0;
+	for (std::size_t i = 0; i < len; ++i) {
+		hash += detail::byte(p[i]);
+	}
+	return hash;
+}
+
+template <typename Char>
+constexpr unsigned int rs_hash_n(const Char * p, std::size_t len) {
+	std::uint32_t b = 378551;
+	std::uint32_t a = 63689;
+	std::uint32_t hash = 0;
+	for (std::size_t i = 0; i < len; ++i) {
+		hash = hash * a + detail::byte(p[i]);
+		a = a * b;
+	}
+	return hash;
+}
+
+template <typename Char>
+constexpr unsigned int js_hash_n(const Char * p, std::size_t len) {
+	std::uint32_t hash = 1315423911;
+	for (std::size_t i = 0; i < len; ++i) {
+		hash ^= ((hash << 5) + detail::byte(p[i]) + (hash >> 2));
+	}
+	return hash;
+}
+
+template <typename Char>
+constexpr unsigned int pjw_hash_n(const Char * p, std::size_t len) {
+	std::uint32_t hash = 0;
+	for (std::size_t i = 0; i < len; ++i) {
+		hash = (hash << 4) + detail::byte(p[i]);
+		const std::uint32_t test = hash & 0xF0000000U;
+		if (test) {
+			hash = ((hash ^ (test >> 24)) & 0x0FFFFFFFU);
+		}
+	}
+	return hash;
+}
+
+template <typename Char>
+constexpr unsigned int elf_hash_n(const Char * p, std::size_t len) {
+	std::uint32_t hash = 0;
+	for (std::size_t i = 0; i < len; ++i) {
+		hash = (hash << 4) + detail::byte(p[i]);
+		const std::uint32_t x = hash & 0xF0000000U;
+		if (x) {
+			hash ^= (x >> 24);
+			hash &= ~x;
+		}
+	}
+	return hash;
+}
+
+template <typename Char>
+constexpr unsigned int bkdr_hash_n(const Char * p, std::size_t len) {
+	std::uint32_t hash = 0;
+	for (std::size_t i = 0; i < len; ++i) {
+		hash = (hash * 131313) + detail::byte(p[i]);
+	}
+	return hash;
+}
+
+template <typename Char>
+constexpr unsigned int mabkdr_hash_n(const Char * p, std::size_t len) {
+	std::uint32_t hash = 0;
+	for (std::size_t i = 0; i < len; ++i) {
+		hash = (hash * 131313) + detail::byte(p[i]) + static_cast<std::uint32_t>(i);
+	}
+	return hash;
+}
+
+template <typename Char>
+constexpr unsigned int dek_hash_n(const Char * p, std::size_t len) {
+	std::uint32_t hash = static_cast<std::uint32_t>(len);
+	for (std::size_t i = 0; i < len; ++i) {
+		hash = ((hash << 5) ^ (hash >> 27)) ^ detail::byte(p[i]);
+	}
+	return hash;
+}
+
+template <typename Char>
+constexpr unsigned int ap_hash_n(const Char * p, std::size_t len) {
+	std::uint32_t hash = 0;
+	for (std::size_t i = 0; i < len; ++i) {
+		const unsigned int c = detail::byte(p[i]);
+		hash ^= ((i & 1) == 0) ?
+			((hash << 7) ^ c ^ (hash >> 3)) :
+			(~((hash << 11) ^ c ^ (hash >> 5)));
+	}
+	return hash;
+}
+
+template <typename Char>
+constexpr unsigned int ly_hash_n(const Char * p, std::size_t len) {
+	std::uint32_t hash = 0;
+	for (std::size_t i = 0; i < len; ++i) {
+		hash = (hash * 1664525) + detail::byte(p[i]) + 1013904223;
+	}
+	return hash;
+}
+
+template <typename Char>
+constexpr unsigned int rot13_hash_n(const Char * p, std::size_t len) {
+	std::uint32_t hash = 0;
+	/* rot13_hash() does not mask the byte, so keep plain char signedness */
+	for (std::size_t i = 0; i < len; ++i) {
+		const unsigned int c = static_cast<unsigned int>(static_cast<char>(detail::byte(p[i])));
+		hash = (hash + c - (hash << 13)) | (hash >> 19);
+	}
+	return hash;
+}
+
+template <typename Char>
+constexpr unsigned int faq6_hash_n(const Char * p, std::size_t len) {
+	std::uint32_t hash = 0;
+	for (std::size_t i = 0; i < len; ++i) {
+		hash += detail::byte(p[i]);
+		hash += (hash << 10);
+		hash ^= (hash >> 6);
+	}
+	hash += (hash << 3);
+	hash ^= (hash >> 11);
+	hash += (hash << 15);
+	return hash;
+}
+
+template <typename Char>
+constexpr unsigned int fnv1_hash_n(const Char * p, std::size_t len) {
+	std::uint32_t hash = 0x811c9dc5;
+	for (std::size_t i = 0; i < len; ++i) {
+		hash *= 0x01000193;
+		hash ^= detail::byte(p[i]);
+	}
+	return hash;
+}
+
+template <typename Char>
+constexpr unsigned int fnv1a_hash_n(const Char * p, std::size_t len) {
+	std::uint32_t hash = 0x811c9dc5;
+	for (std::size_t i = 0; i < len; ++i) {
+		hash ^= detail::byte(p[i]);
+		hash *= 0x01000193;
+	}
+	return hash;
+}
+
+template <typename Char>
+constexpr unsigned int q3cvars_hash_n(const Char * p, std::size_t len) {
+	std::uint32_t hash = 0;
+	for (std::size_t i = 0; i < len; ++i) {
+		unsigned int c = detail::byte(p[i]);
+		if (c >= 'A' && c <= 'Z') {
+			c = c - 'A' + 'a';
+		}
+		hash += c * (static_cast<std::uint32_t>(i) + 119);
+	}
+	return hash;
+}
+
+template <typename Char>
+constexpr unsigned int my1_hash_n(const Char * p, std::size_t len) {
+	std::uint32_t hash = 0;
+	for (std::size_t i = 0; i < len; ++i) {
+		const unsigned int c = detail::byte(p[i]);
+		if (c > 'A' && c < 'Z') {
+			hash += c - 'A';
+			hash += (hash << 10);
+			hash ^= (hash >> 6);
+		}
+		else
+		if (c > 'a' && c < 'z') {
+			hash += c - 'a';
+			hash += (hash << 10);
+			hash ^= (hash >> 6);
+		}
+	}
+	hash += (hash << 3);
+	hash ^= (hash >> 11);
+	hash += (hash << 15);
+	return hash;
+}
+
+
+/*****************************************************************************
+ * 64-bit variants
+ ****************************************************************************/
+
+namespace detail {
+
+constexpr std::uint64_t fnv64_offset_basis = 0xcbf29ce484222325ULL;
+constexpr std::uint64_t fnv64_prime = 0x00000100000001b3ULL;
+
+} /* namespace detail */
+
+template <typename Char>
+constexpr std::uint64_t djb2_hash64_n(const Char * p, std::size_t len) {
+	std::uint64_t hash = 5381;
+	for (std::size_t i = 0; i < len; ++i) {
+		hash = ((hash << 5) + hash) + detail::byte(p[i]);
+	}
+	return hash;
+}
+
+template <typename Char>
+constexpr std::uint64_t sdbm_hash64_n(const Char * p, std::size_t len) {
+	std::uint64_t hash = 0;
+	for (std::size_t i = 0; i < len; ++i) {
+		hash = detail::byte(p[i]) + (hash << 6) + (hash << 16) - hash;
+	}
+	return hash;
+}
+
+template <typename Char>
+constexpr std::uint64_t bkdr_hash64_n(const Char * p, std::size_t len) {
+	std::uint64_t hash = 0;
+	for (std::size_t i = 0; i < len; ++i) {
+		hash = (hash * 131313) + detail::byte(p[i]);
+	}
+	return hash;
+}
+
+template <typename Char>
+constexpr std::uint64_t fnv1_hash64_n(const Char * p, std::size_t len) {
+	std::uint64_t hash = detail::fnv64_offset_basis;
+	for (std::size_t i = 0; i < len; ++i) {
+		hash *= detail::fnv64_prime;
+		hash ^= detail::byte(p[i]);
+	}
+	return hash;
+}
+
+template <typename Char>
+constexpr std::uint64_t fnv1a_hash64_n(const Char * p, std::size_t len) {
+	std::uint64_t hash = detail::fnv64_offset_basis;
+	for (std::size_t i = 0; i < len; ++i) {
+		hash ^= detail::byte(p[i]);
+		hash *= detail::fnv64_prime;
+	}
+	return hash;
+}
+
+
+/*****************************************************************************
+ * block hashes for long keys
+ ****************************************************************************/
+
+namespace detail {
+
+constexpr std::uint32_t xxh32_prime1 = 0x9E3779B1U;
+constexpr std::uint32_t xxh32_prime2 = 0x85EBCA77U;
+constexpr std::uint32_t xxh32_prime3 = 0xC2B2AE3DU;
+constexpr std::uint32_t xxh32_prime4 = 0x27D4EB2FU;
+constexpr std::uint32_t xxh32_prime5 = 0x165667B1U;
+
+constexpr std::uint32_t xxh32_round(std::uint32_t acc, std::uint32_t lane) {
+	return rotl32(acc + lane * xxh32_prime2, 13) * xxh32_prime1;
+}
+
+template <typename Char>
+constexpr std::uint32_t xxh32_seeded(const Char * p, std::size_t len, std::uint32_t seed) {
+	std::size_t i = 0;
+	std::uint32_t hash = 0;
+
+	if (len >= 16) {
+		std::uint32_t v1 = seed + xxh32_prime1 + xxh32_prime2;
+		std::uint32_t v2 = seed + xxh32_prime2;
+		std::uint32_t v3 = seed;
+		std::uint32_t v4 = seed - xxh32_prime1;
+		do {
+			v1 = xxh32_round(v1, read32le(p + i));
+			v2 = xxh32_round(v2, read32le(p + i + 4));
+			v3 = xxh32_round(v3, read32le(p + i + 8));
+			v4 = xxh32_round(v4, read32le(p + i + 12));
+			i += 16;
+		} while (len - i >= 16);
+		hash = rotl32(v1, 1) + rotl32(v2, 7) + rotl32(v3, 12) + rotl32(v4, 18);
+	}
+	else {
+		hash = seed + xxh32_prime5;
+	}
+
+	hash += static_cast<std::uint32_t>(len);
+	for (; len - i >= 4; i += 4) {
+		hash = rotl32(hash + read32le(p + i) * xxh32_prime3, 17) * xxh32_prime4;
+	}
+	for (; i < len; ++i) {
+		hash = rotl32(hash + byte(p[i]) * xxh32_prime5, 11) * xxh32_prime1;
+	}
+
+	hash ^= hash >> 15;
+	hash *= xxh32_prime2;
+	hash ^= hash >> 13;
+	hash *= xxh32_prime3;
+	hash ^= hash >> 16;
+	return hash;
+}
+
+constexpr std::uint64_t xxh64_prime1 = 0x9E3779B185EBCA87ULL;
+constexpr std::uint64_t xxh64_prime2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr std::uint64_t xxh64_prime3 = 0x165667B19E3779F9ULL;
+constexpr std::uint64_t xxh64_prime4 = 0x85EBCA77C2B2AE63ULL;
+constexpr std::uint64_t xxh64_prime5 = 0x27D4EB2F165667C5ULL;
+
+constexpr std::uint64_t xxh64_round(std::uint64_t acc, std::uint64_t lane) {
+	return rotl64(acc + lane * xxh64_prime2, 31) * xxh64_prime1;
+}
+
+constexpr std::uint64_t xxh64_merge(std::uint64_t hash, std::uint64_t acc) {
+	return (hash ^ xxh64_round(0, acc)) * xxh64_prime1 + xxh64_prime4;
+}
+
+template <typename Char>
+constexpr std::uint32_t murmur3_seeded(const Char * p, std::size_t len, std::uint32_t seed) {
+	const std::uint32_t c1 = 0xcc9e2d51U;
+	const std::uint32_t c2 = 0x1b873593U;
+	std::uint32_t hash = seed;
+	std::uint32_t k = 0;
+	std::size_t i = 0;
+
+	for (; len - i >= 4; i += 4) {
+		k = read32le(p + i) * c1;
+		k = rotl32(k, 15) * c2;
+		hash ^= k;
+		hash = rotl32(hash, 13) * 5 + 0xe6546b64U;
+	}
+
+	k = 0;
+	switch (len & 3) {
+		case 3:
+			k ^= static_cast<std::uint32_t>(byte(p[i + 2])) << 16;
+			/* fall through */
+		case 2:
+			k ^= static_cast<std::uint32_t>(byte(p[i + 1])) << 8;
+			/* fall through */
+		case 1:
+			k ^= byte(p[i]);
+			k = rotl32(k * c1, 15) * c2;
+			hash ^= k;
+	}
+
+	hash ^= static_cast<std::uint32_t>(len);
+	hash ^= hash >> 16;
+	hash *= 0x85ebca6bU;
+	hash ^= hash >> 13;
+	hash *= 0xc2b2ae35U;
+	hash ^= hash >> 16;
+	return hash;
+}
+
+constexpr std::uint64_t wyp0 = 0x2d358dccaa6c78a5ULL;
+constexpr std::uint64_t wyp1 = 0x8bb84b93962eacc9ULL;
+constexpr std::uint64_t wyp2 = 0x4b33a62ed433d4a3ULL;
+constexpr std::uint64_t wyp3 = 0x4d5a2da51de1aa47ULL;
+
+/* low and high halves of the 128-bit product */
+struct wy128 {
+	std::uint64_t lo;
+	std::uint64_t hi;
+};
+
+constexpr wy128 wymum(std::uint64_t a, std::uint64_t b) {
+#ifdef __SIZEOF_INT128__
+	__extension__ typedef unsigned __int128 u128;
+	const u128 r = static_cast<u128>(a) * b;
+	return wy128{ static_cast<std::uint64_t>(r), static_cast<std::uint64_t>(r >> 64) };
+#else
+	const std::uint64_t ha = a >> 32, hb = b >> 32, la = static_cast<std::uint32_t>(a), lb = static_cast<std::uint32_t>(b);
+	const std::uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+	const std::uint64_t t = rl + (rm0 << 32);
+	const std::uint64_t lo = t + (rm1 << 32);
+	const std::uint64_t c = (t < rl) + (lo < t);
+	return wy128{ lo, rh + (rm0 >> 32) + (rm1 >> 32) + c };
+#endif
+}
+
+constexpr std::uint64_t wymix(std::uint64_t a, std::uint64_t b) {
+	const wy128 r = wymum(a, b);
+	return r.lo ^ r.hi;
+}
+
+template <typename Char>
+constexpr std::uint64_t wyr3(const Char * p, std::size_t k) {
+	return (static_cast<std::uint64_t>(byte(p[0])) << 16) | (static_cast<std::uint64_t>(byte(p[k >> 1])) << 8) | byte(p[k - 1]);
+}
+
+/* the CRC-32C table of hashfns.c, built by the compiler */
+struct crc32c_table {
+	std::uint32_t v[256];
+
+	constexpr crc32c_table() : v() {
+		for (std::uint32_t n = 0; n < 256; ++n) {
+			std::uint32_t crc = n;
+			for (int k = 0; k < 8; ++k) {
+				crc = (crc >> 1) ^ (0x82F63B78U & (0U - (crc & 1)));
+			}
+			v[n] = crc;
+		}
+	}
+};
+
+constexpr crc32c_table crc32c_tab{};
+
+} /* namespace detail */
+
+template <typename Char>
+constexpr unsigned int xxh32_hash_n(const Char * p, std::size_t len) {
+	return detail::xxh32_seeded(p, len, 0);
+}
+
+template <typename Char>
+constexpr std::uint64_t xxh64_hash_n(const Char * p, std::size_t len) {
+	using namespace detail;
+	std::size_t i = 0;
+	std::uint64_t hash = 0;
+
+	if (len >= 32) {
+		std::uint64_t v1 = xxh64_prime1 + xxh64_prime2;
+		std::uint64_t v2 = xxh64_prime2;
+		std::uint64_t v3 = 0;
+		std::uint64_t v4 = 0 - xxh64_prime1;
+		do {
+			v1 = xxh64_round(v1, read64le(p + i));
+			v2 = xxh64_round(v2, read64le(p + i + 8));
+			v3 = xxh64_round(v3, read64le(p + i + 16));
+			v4 = xxh64_round(v4, read64le(p + i + 24));
+			i += 32;
+		} while (len - i >= 32);
+		hash = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+		hash = xxh64_merge(hash, v1);
+		hash = xxh64_merge(hash, v2);
+		hash = xxh64_merge(hash, v3);
+		hash = xxh64_merge(hash, v4);
+	}
+	else {
+		hash = xxh64_prime5;
+	}
+
+	hash += static_cast<std::uint64_t>(len);
+	for (; len - i >= 8; i += 8) {
+		hash ^= xxh64_round(0, read64le(p + i));
+		hash = rotl64(hash, 27) * xxh64_prime1 + xxh64_prime4;
+	}
+	if (len - i >= 4) {
+		hash ^= static_cast<std::uint64_t>(read32le(p + i)) * xxh64_prime1;
+		hash = rotl64(hash, 23) * xxh64_prime2 + xxh64_prime3;
+		i += 4;
+	}
+	for (; i < len; ++i) {
+		hash ^= byte(p[i]) * xxh64_prime5;
+		hash = rotl64(hash, 11) * xxh64_prime1;
+	}
+
+	hash ^= hash >> 33;
+	hash *= xxh64_prime2;
+	hash ^= hash >> 29;
+	hash *= xxh64_prime3;
+	hash ^= hash >> 32;
+	return hash;
+}
+
+template <typename Char>
+constexpr unsigned int murmur3_hash_n(const Char * p, std::size_t len) {
+	return detail::murmur3_seeded(p, len, 0);
+}
+
+template <typename Char>
+constexpr std::uint64_t wy_hash_n(const Char * p, std::size_t len) {
+	using namespace detail;
+	std::uint64_t seed = wymix(wyp0, wyp1);
+	std::uint64_t x = 0, y = 0;
+
+	if (len <= 16) {
+		if (len >= 4) {
+			x = (static_cast<std::uint64_t>(read32le(p)) << 32) | read32le(p + ((len >> 3) << 2));
+			y = (static_cast<std::uint64_t>(read32le(p + len - 4)) << 32) | read32le(p + len - 4 - ((len >> 3) << 2));
+		}
+		else
+		if (len > 0) {
+			x = wyr3(p, len);
+		}
+	}
+	else {
+		std::size_t i = len;
+		if (i > 48) {
+			std::uint64_t see1 = seed, see2 = seed;
+			do {
+				seed = wymix(read64le(p) ^ wyp1, read64le(p + 8) ^ seed);
+				see1 = wymix(read64le(p + 16) ^ wyp2, read64le(p + 24) ^ see1);
+				see2 = wymix(read64le(p + 32) ^ wyp3, read64le(p + 40) ^ see2);
+				p += 48;
+				i -= 48;
+			} while (i > 48);
+			seed ^= see1 ^ see2;
+		}
+		while (i > 16) {
+			seed = wymix(read64le(p) ^ wyp1, read64le(p + 8) ^ seed);
+			p += 16;
+			i -= 16;
+		}
+		x = read64le(p + i - 16);
+		y = read64le(p + i - 8);
+	}
+
+	const wy128 r = wymum(x ^ wyp1, y ^ seed);
+	return wymix(r.lo ^ wyp0 ^ len, r.hi ^ wyp1);
+}
+
+template <typename Char>
+constexpr unsigned int crc32c_hash_n(const Char * p, std::size_t len) {
+	std::uint32_t crc = ~0U;
+	for (std::size_t i = 0; i < len; ++i) {
+		crc = detail::crc32c_tab.v[(crc ^ detail::byte(p[i])) & 0xff] ^ (crc >> 8);
+	}
+	return ~crc;
+}
+
+
+/*****************************************************************************
+ * NUL-terminated strings, the same values as xxx_hash_n(s, strlen(s))
+ ****************************************************************************/
+
+#define STRHASH_CSTR(fn, type) \
+template <typename Char> \
+constexpr type fn(const Char * s) { \
+	return fn##_n(s, detail::length(s)); \
+}
+
+STRHASH_CSTR(djb2_hash, unsigned int)
+STRHASH_CSTR(sdbm_hash, unsigned int)
+STRHASH_CSTR(lose_hash, unsigned int)
+STRHASH_CSTR(rs_hash, unsigned int)
+STRHASH_CSTR(js_hash, unsigned int)
+STRHASH_CSTR(pjw_hash, unsigned int)
+STRHASH_CSTR(elf_hash, unsigned int)
+STRHASH_CSTR(bkdr_hash, unsigned int)
+STRHASH_CSTR(mabkdr_hash, unsigned int)
+STRHASH_CSTR(dek_hash, unsigned int)
+STRHASH_CSTR(ap_hash, unsigned int)
+STRHASH_CSTR(ly_hash, unsigned int)
+STRHASH_CSTR(rot13_hash, unsigned int)
+STRHASH_CSTR(faq6_hash, unsigned int)
+STRHASH_CSTR(fnv1_hash, unsigned int)
+STRHASH_CSTR(fnv1a_hash, unsigned int)
+STRHASH_CSTR(q3cvars_hash, unsigned int)
+STRHASH_CSTR(my1_hash, unsigned int)
+STRHASH_CSTR(djb2_hash64, std::uint64_t)
+STRHASH_CSTR(sdbm_hash64, std::uint64_t)
+STRHASH_CSTR(bkdr_hash64, std::uint64_t)
+STRHASH_CSTR(fnv1_hash64, std::uint64_t)
+STRHASH_CSTR(fnv1a_hash64, std::uint64_t)
+STRHASH_CSTR(xxh32_hash, unsigned int)
+STRHASH_CSTR(xxh64_hash, std::uint64_t)
+STRHASH_CSTR(murmur3_hash, unsigned int)
+STRHASH_CSTR(wy_hash, std::uint64_t)
+STRHASH_CSTR(crc32c_hash, unsigned int)
+
+#undef STRHASH_CSTR
+
+template <typename Char>
+constexpr unsigned int xxh32_hash_seeded(const Char * s, std::uint32_t seed) {
+	return detail::xxh32_seeded(s, detail::length(s), seed);
+}
+
+template <typename Char>
+constexpr unsigned int murmur3_hash_seeded(const Char * s, std::uint32_t seed) {
+	return detail::murmur3_seeded(s, detail::length(s), seed);
+}
+
+
+/*****************************************************************************
+ * user-defined literals
+ ****************************************************************************/
+
+inline namespace literals {
+
+#define STRHASH_LITERAL(suffix, fn) \
+STRHASH_CONSTEVAL auto operator""_##suffix(const char * s, std::size_t len) { \
+	return fn##_n(s, len); \
+}
+
+STRHASH_LITERAL(djb2, djb2_hash)
+STRHASH_LITERAL(sdbm, sdbm_hash)
+STRHASH_LITERAL(lose, lose_hash)
+STRHASH_LITERAL(rs, rs_hash)
+STRHASH_LITERAL(js, js_hash)
+STRHASH_LITERAL(pjw, pjw_hash)
+STRHASH_LITERAL(elf, elf_hash)
+STRHASH_LITERAL(bkdr, bkdr_hash)
+STRHASH_LITERAL(mabkdr, mabkdr_hash)
+STRHASH_LITERAL(dek, dek_hash)
+STRHASH_LITERAL(ap, ap_hash)
+STRHASH_LITERAL(ly, ly_hash)
+STRHASH_LITERAL(rot13, rot13_hash)
+STRHASH_LITERAL(faq6, faq6_hash)
+STRHASH_LITERAL(fnv1, fnv1_hash)
+STRHASH_LITERAL(fnv1a, fnv1a_hash)
+STRHASH_LITERAL(q3cvars, q3cvars_hash)
+STRHASH_LITERAL(my1, my1_hash)
+STRHASH_LITERAL(djb2_64, djb2_hash64)
+STRHASH_LITERAL(sdbm_64, sdbm_hash64)
+STRHASH_LITERAL(bkdr_64, bkdr_hash64)
+STRHASH_LITERAL(fnv1_64, fnv1_hash64)
+STRHASH_LITERAL(fnv1a_64, fnv1a_hash64)
+STRHASH_LITERAL(xxh32, xxh32_hash)
+STRHASH_LITERAL(xxh64, xxh64_hash)
+STRHASH_LITERAL(murmur3, murmur3_hash)
+STRHASH_LITERAL(wy, wy_hash)
+STRHASH_LITERAL(crc32c, crc32c_hash)
+
+#undef STRHASH_LITERAL
+
+} /* inline namespace literals */
+
+} /* namespace strhash */
+
+#endif /* #ifndef HASHFNS_HPP */
+
+/* vim: set ts=4 tw=78 noet ft=cpp: */
@@ -0,0 +1,627 @@
+/*****************************************************************************
+ * Copyright (C) 2020 Alexander Potylitsin <apotyn@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ *
+ ****************************************************************************/
+
+/*****************************************************************************
+ * hashsel: picks a function of hashfns.h for a key corpus
+ *
+ * The corpus is mapped into memory and every length-aware hash, which gives
+ * the same values as its NUL-terminated sibling on keys without NULs, is
+ * run over all of it on all cores. Per hash it reports:
+ *
+ *   collisions     keys whose low 32 bits of hash were seen before, next to
+ *                  the count expected of a random function
+ *   load_variance  variance of the bucket loads of a power-of-two table
+ *                  indexed by the low bits, relative to a random function
+ *   probe_length   mean probes of a successful lookup in that table with
+ *                  linear probing
+ *   avalanche_bias mean |2 P(output bit flips) - 1| over flips of the
+ *                  first 32 key bytes, 0 is ideal
+ *   ns_per_key     hashing time per key and thread, and GB/s of all cores
+ *
+ * and ends with a recommendation. Duplicate keys collide under any hash.
+ *
+ * usage: hashsel [-j] [-l] [-t threads] [-f function] [-L load]
+ *                [-n table keys] [-a avalanche keys] corpus
+ *   -j  JSON instead of CSV
+ *   -l  keys are prefixed by their 32-bit little-endian length instead of
+ *       being separated by newlines
+ *   -t  threads, default all online cores
+ *   -f  only functions whose name contains the string
+ *   -L  load factor of the table, default 0.5
+ *   -n  most keys put into the table, sampled evenly, default 2^25
+ *   -a  keys sampled for avalanche, default 2000
+ ****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "hashfns.h"
+
+
+struct hashfn {
+	const char * name;
+	bool wide;
+	union {
+		unsigned int (* mem)(const void *, size_t);
+		uint64_t (* mem64)(const void *, size_t);
+	} fn;
+};
+
+static const struct hashfn hashfns[] = {
+#define HASHFN_N(f) { .name = #f, .wide = false, .fn = { .mem = f } },
+#define HASHFN64_N(f) { .name = #f, .wide = true, .fn = { .mem64 = f } },
+#include "hashfns.def"
+};
+
+static inline uint64_t hash_key(const struct hashfn * h, const unsigned char * key, size_t len) {
+	return h->wide ? h->fn.mem64(key, len) : (uint64_t)h->fn.mem(key, len);
+}
+
+static void * xmalloc(size_t size) {
+	void * p = malloc(size);
+	if (!p) {
+		fprintf(stderr, "hashsel: out of memory\n");
+		exit(2);
+	}
+	return p;
+}
+
+static double now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+
+/*****************************************************************************
+ * corpus
+ ****************************************************************************/
+
+struct corpus {
+	const unsigned char * base;
+	size_t size;
+	bool length_prefixed;
+};
+
+/* a byte range of whole keys, keys are numbered across the corpus */
+struct chunk {
+	size_t begin;
+	size_t end;
+	uint64_t first;
+	uint64_t nkeys;
+};
+
+/* steps over the key at *pos, returns false at end or on a truncated key. */
+static inline bool next_key(const struct corpus * c, size_t * pos, size_t end,
+	const unsigned char ** key, size_t * len) {
+
+	if (c->length_prefixed) {
+		if (end - *pos < 4) return false;
+		const unsigned char * p = c->base + *pos;
+		size_t n = (size_t)p[0] | (size_t)p[1] << 8 | (size_t)p[2] << 16 | (size_t)p[3] << 24;
+		if (end - *pos - 4 < n) return false;
+		*key = p + 4;
+		*len = n;
+		*pos += 4 + n;
+		return true;
+	}
+
+	/* empty lines are skipped, CRLF is taken as well. */
+	while (*pos < end) {
+		const unsigned char * p = c->base + *pos;
+		const unsigned char * nl = memchr(p, '\n', end - *pos);
+		size_t n = nl ? (size_t)(nl - p) : end - *pos;
+		*pos += n + (nl ? 1 : 0);
+		if (n && '\r' == p[n - 1]) --n;
+		if (n) {
+			*key = p;
+			*len = n;
+			return true;
+		}
+	}
+	return false;
+}
+
+static void corpus_open(struct corpus * c, const char * path) {
+	struct stat st;
+	int fd = open(path, O_RDONLY);
+	if (fd < 0 || fstat(fd, &st) < 0) {
+		perror(path);
+		exit(2);
+	}
+	c->size = (size_t)st.st_size;
+	c->base = c->size ? mmap(NULL, c->size, PROT_READ, MAP_SHARED, fd, 0) : NULL;
+	close(fd);
+	if (MAP_FAILED == (void *)c->base) {
+		perror(path);
+		exit(2);
+	}
+	if (c->size) {
+		madvise((void *)c->base, c->size, MADV_SEQUENTIAL);
+	}
+}
+
+/* splits the corpus into about n chunks starting at key boundaries. */
+static struct chunk * corpus_split(const struct corpus * c, size_t n, size_t * nchunks) {
+	struct chunk * chunks = xmalloc((n + 1) * sizeof(*chunks));
+	size_t k = 0, pos = 0;
+
+	if (c->length_prefixed) {
+		/* only a walk over the lengths finds the boundaries. */
+		const unsigned char * key;
+		size_t len;
+		chunks[0].begin = 0;
+		while (pos < c->size) {
+			size_t limit = (k + 1) * (c->size / n + 1);
+			while (pos < limit && next_key(c, &pos, c->size, &key, &len));
+			if (pos < limit) break;
+			chunks[k].end = pos;
+			chunks[++k].begin = pos;
+		}
+		chunks[k].end = pos;
+		if (pos < c->size) {
+			fprintf(stderr, "hashsel: truncated key at offset %zu, ignoring the rest\n", pos);
+		}
+		++k;
+	}
+	else {
+		for (size_t i = 0; i < n && pos < c->size; ++i) {
+			size_t end = (i + 1 == n) ? c->size : (i + 1) * (c->size / n);
+			if (end < pos) continue;
+			const unsigned char * nl = end < c->size ? memchr(c->base + end, '\n', c->size - end) : NULL;
+			end = nl ? (size_t)(nl - c->base) + 1 : c->size;
+			chunks[k].begin = pos;
+			chunks[k].end = end;
+			++k;
+			pos = end;
+		}
+	}
+
+	*nchunks = k;
+	return chunks;
+}
+
+
+/*****************************************************************************
+ * parallel passes over the chunks
+ ****************************************************************************/
+
+struct pass {
+	const struct corpus * corpus;
+	struct chunk * chunks;
+	size_t nchunks;
+	size_t next;						/* next chunk to take, atomic */
+	const struct hashfn * h;
+
+	/* stats pass */
+	uint64_t * seen;					/* 2^32 bits of low hash bits */
+	uint32_t * buckets;
+	uint64_t mask;
+	uint64_t stride;					/* every stride-th key is put into the table */
+};
+
+enum pass_kind { PASS_COUNT, PASS_HASH, PASS_STATS };
+
+struct worker {
+	pthread_t thread;
+	struct pass * pass;
+	enum pass_kind kind;
+	uint64_t result;
+};
+
+static void * worker_run(void * arg) {
+	struct worker * w = arg;
+	struct pass * p = w->pass;
+	const struct hashfn * h = p->h;
+	uint64_t result = 0;
+	size_t i;
+
+	while ((i = __atomic_fetch_add(&p->next, 1, __ATOMIC_RELAXED)) < p->nchunks) {
+		struct chunk * ch = &p->chunks[i];
+		const unsigned char * key;
+		size_t len, pos = ch->begin;
+		uint64_t idx = ch->first;
+
+		switch (w->kind) {
+			case PASS_COUNT:
+				while (next_key(p->corpus, &pos, ch->end, &key, &len)) ++idx;
+				ch->nkeys = idx - ch->first;
+				break;
+
+			case PASS_HASH:
+				while (next_key(p->corpus, &pos, ch->end, &key, &len)) {
+					result += hash_key(h, key, len);
+				}
+				break;
+
+			case PASS_STATS:
+				while (next_key(p->corpus, &pos, ch->end, &key, &len)) {
+					const uint64_t v = hash_key(h, key, len);
+					const uint32_t low = (uint32_t)v;
+					const uint64_t bit = 1ULL << (low & 63);
+					if (__atomic_fetch_or(&p->seen[low >> 6], bit, __ATOMIC_RELAXED) & bit) {
+						++result;
+					}
+					if (0 == idx++ % p->stride) {
+						__atomic_fetch_add(&p->buckets[v & p->mask], 1, __ATOMIC_RELAXED);
+					}
+				}
+				break;
+		}
+	}
+
+	w->result = result;
+	return NULL;
+}
+
+/* runs the pass on nthreads threads, returns the sum of their results. */
+static uint64_t run(struct pass * p, enum pass_kind kind, unsigned int nthreads) {
+	struct worker * w = xmalloc(nthreads * sizeof(*w));
+	uint64_t sum = 0;
+
+	p->next = 0;
+	for (unsigned int t = 0; t < nthreads; ++t) {
+		w[t].pass = p;
+		w[t].kind = kind;
+		w[t].result = 0;
+		if (pthread_create(&w[t].thread, NULL, worker_run, &w[t]) != 0) {
+			fprintf(stderr, "hashsel: can not create threads\n");
+			exit(2);
+		}
+	}
+	for (unsigned int t = 0; t < nthreads; ++t) {
+		pthread_join(w[t].thread, NULL);
+		sum += w[t].result;
+	}
+	free(w);
+	return sum;
+}
+
+/* a zeroed mapping, dropped pages read back as zeros. */
+static void * zeroed(size_t size) {
+	void * p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if (MAP_FAILED == p) {
+		fprintf(stderr, "hashsel: out of memory\n");
+		exit(2);
+	}
+	return p;
+}
+
+static void rezero(void * p, size_t size) {
+	if (madvise(p, size, MADV_DONTNEED) != 0) {
+		memset(p, 0, size);
+	}
+}
+
+
+/*****************************************************************************
+ * metrics
+ ****************************************************************************/
+
+struct result {
+	const struct hashfn * h;
+	uint64_t collisions;
+	double expected_collisions;
+	double load_variance;
+	double variance_ratio;
+	double probe_length;
+	double avalanche_bias;
+	double ns_per_key;
+	double gb_per_s;
+};
+
+/* collisions of n keys thrown into m slots at random: n - occupied slots */
+static double random_collisions(double n, double m) {
+	const double x = n / m;
+	if (x < 1e-4) {
+		return m * (x * x / 2 - x * x * x / 6);
+	}
+	return m * (x + expm1(-x));
+}
+
+/* variance of the bucket loads and mean probes of a successful search with
+ * linear probing. The total displacement of linear probing does not depend
+ * on the insertion order, so the bucket loads give it: whatever does not
+ * fit into a bucket is carried over to the next one. */
+static void table_stats(const uint32_t * buckets, uint64_t size, uint64_t keys, struct result * r) {
+	const double mean = (double)keys / size;
+	double var = 0;
+	uint64_t carry = 0;
+
+	for (uint64_t i = 0; i < size; ++i) {
+		const double d = buckets[i] - mean;
+		var += d * d;
+		carry += buckets[i];
+		carry -= carry ? 1 : 0;
+	}
+
+	/* the carry out of the last bucket wraps around to the first one. */
+	double displacement = 0;
+	for (uint64_t i = 0; i < size; ++i) {
+		carry += buckets[i];
+		carry -= carry ? 1 : 0;
+		displacement += carry;
+	}
+
+	r->load_variance = var / size;
+	r->variance_ratio = mean > 0 ? r->load_variance / (mean * (1 - 1.0 / size)) : 0;
+	r->probe_length = keys ? 1 + displacement / keys : 0;
+}
+
+struct sample {
+	const unsigned char * key;
+	size_t len;
+};
+
+#define AVALANCHE_BYTES 32
+
+static double avalanche(const struct hashfn * h, const struct sample * samples, size_t n) {
+	const unsigned int out_bits = h->wide ? 64 : 32;
+	uint32_t * flips = calloc(AVALANCHE_BYTES * 8 * 64, sizeof(*flips));
+	uint32_t * trials = calloc(AVALANCHE_BYTES * 8, sizeof(*trials));
+	unsigned char * buf = NULL;
+	size_t cap = 0;
+
+	if (!flips || !trials) {
+		fprintf(stderr, "hashsel: out of memory\n");
+		exit(2);
+	}
+
+	for (size_t s = 0; s < n; ++s) {
+		const size_t len = samples[s].len;
+		if (len > cap) {
+			free(buf);
+			cap = len;
+			buf = xmalloc(cap);
+		}
+		memcpy(buf, samples[s].key, len);
+
+		const uint64_t h0 = hash_key(h, buf, len);
+		const size_t in_bits = 8 * (len < AVALANCHE_BYTES ? len : AVALANCHE_BYTES);
+		for (size_t b = 0; b < in_bits; ++b) {
+			buf[b / 8] ^= (unsigned char)(1U << (b % 8));
+			const uint64_t diff = h0 ^ hash_key(h, buf, len);
+			buf[b / 8] ^= (unsigned char)(1U << (b % 8));
+
+			for (unsigned int o = 0; o < out_bits; ++o) {
+				flips[b * 64 + o] += (uint32_t)(diff >> o) & 1;
+			}
+			++trials[b];
+		}
+	}
+
+	double bias = 0;
+	size_t cells = 0;
+	for (size_t b = 0; b < AVALANCHE_BYTES * 8; ++b) {
+		if (!trials[b]) continue;
+		for (unsigned int o = 0; o < out_bits; ++o) {
+			bias += fabs(2.0 * flips[b * 64 + o] / trials[b] - 1);
+			++cells;
+		}
+	}
+
+	free(buf);
+	free(flips);
+	free(trials);
+	return cells ? bias / cells : 0;
+}
+
+
+/*****************************************************************************
+ * recommendation
+ *
+ * A hash qualifies when its collisions stay within noise of a random
+ * function, its probe length within 2% of the best one and its avalanche
+ * bias under 0.1; the fastest qualifying hash wins. Without any, the one of
+ * the shortest probe length does.
+ ****************************************************************************/
+
+static const struct result * recommend(const struct result * r, size_t n, const char ** why) {
+	double best_probe = 0;
+	for (size_t i = 0; i < n; ++i) {
+		if (0 == i || r[i].probe_length < best_probe) best_probe = r[i].probe_length;
+	}
+
+	const struct result * pick = NULL;
+	for (size_t i = 0; i < n; ++i) {
+		const double slack = 4 * sqrt(r[i].expected_collisions) + 2;
+		if (r[i].collisions <= r[i].expected_collisions * 1.05 + slack &&
+			r[i].probe_length <= best_probe * 1.02 &&
+			r[i].avalanche_bias < 0.1 &&
+			(!pick || r[i].ns_per_key < pick->ns_per_key)) {
+			pick = &r[i];
+		}
+	}
+	if (pick) {
+		*why = "fastest of the hashes behaving like a random function on this corpus";
+		return pick;
+	}
+
+	for (size_t i = 0; i < n; ++i) {
+		if (!pick || r[i].probe_length < pick->probe_length) pick = &r[i];
+	}
+	*why = "no hash behaves like a random function, shortest probe length";
+	return pick;
+}
+
+
+int main(int argc, char ** argv) {
+	const char * only_fn = NULL;
+	bool json = false;
+	struct corpus corpus = { .length_prefixed = false };
+	long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+	unsigned int nthreads = ncpu > 0 ? (unsigned int)ncpu : 1;
+	double load = 0.5;
+	uint64_t table_keys = 1ULL << 25;
+	size_t avalanche_keys = 2000;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "jlt:f:L:n:a:")) != -1) {
+		switch (opt) {
+			case 'j': json = true; break;
+			case 'l': corpus.length_prefixed = true; break;
+			case 't': nthreads = (unsigned int)atoi(optarg); break;
+			case 'f': only_fn = optarg; break;
+			case 'L': load = atof(optarg); break;
+			case 'n': table_keys = strtoull(optarg, NULL, 0); break;
+			case 'a': avalanche_keys = (size_t)atol(optarg); break;
+			default:
+				optind = argc + 1;
+				break;
+		}
+	}
+	if (optind != argc - 1 || !nthreads || load <= 0 || load >= 1 || !table_keys) {
+		fprintf(stderr, "usage: %s [-j] [-l] [-t threads] [-f function] [-L load] [-n table keys] [-a avalanche keys] corpus\n", argv[0]);
+		return 2;
+	}
+
+	corpus_open(&corpus, argv[optind]);
+
+	/* number the keys: count them per chunk, then sum up. */
+	struct pass pass;
+	memset(&pass, 0, sizeof(pass));
+	pass.corpus = &corpus;
+	pass.chunks = corpus_split(&corpus, (size_t)nthreads * 64, &pass.nchunks);
+	run(&pass, PASS_COUNT, nthreads);
+
+	uint64_t nkeys = 0;
+	for (size_t i = 0; i < pass.nchunks; ++i) {
+		pass.chunks[i].first = nkeys;
+		nkeys += pass.chunks[i].nkeys;
+	}
+	if (!nkeys) {
+		fprintf(stderr, "hashsel: no keys in %s\n", argv[optind]);
+		return 2;
+	}
+
+	/* the leading keys of every chunk make the avalanche sample. */
+	struct sample * samples = xmalloc((avalanche_keys + 1) * sizeof(*samples));
+	size_t nsamples = 0;
+	const size_t per_chunk = avalanche_keys / pass.nchunks + 1;
+	for (size_t i = 0; i < pass.nchunks && nsamples < avalanche_keys; ++i) {
+		size_t pos = pass.chunks[i].begin;
+		for (size_t k = 0; k < per_chunk && nsamples < avalanche_keys &&
+			next_key(&corpus, &pos, pass.chunks[i].end, &samples[nsamples].key, &samples[nsamples].len); ++k) {
+			++nsamples;
+		}
+	}
+
+	/* the table takes every stride-th key, at most table_keys of them. */
+	pass.stride = (nkeys + table_keys - 1) / table_keys;
+	const uint64_t in_table = (nkeys + pass.stride - 1) / pass.stride;
+	uint64_t size = 1;
+	while (size * load < in_table) size <<= 1;
+	pass.mask = size - 1;
+
+	const size_t seen_bytes = (1ULL << 32) / 8;
+	pass.seen = zeroed(seen_bytes);
+	pass.buckets = zeroed(size * sizeof(*pass.buckets));
+
+	const size_t nfns = sizeof(hashfns) / sizeof(hashfns[0]);
+	struct result * results = xmalloc(nfns * sizeof(*results));
+	size_t nresults = 0;
+
+	if (!json) {
+		printf("# %" PRIu64 " keys, %zu bytes, table of %" PRIu64 " buckets holding %" PRIu64 " keys, %u threads\n",
+			nkeys, corpus.size, size, in_table, nthreads);
+		printf("function,bits,collisions,expected_collisions,load_variance,variance_ratio,"
+			"probe_length,avalanche_bias,ns_per_key,gb_per_s\n");
+	}
+
+	for (size_t f = 0; f < nfns; ++f) {
+		const struct hashfn * h = &hashfns[f];
+		if (only_fn && !strstr(h->name, only_fn)) continue;
+
+		struct result * r = &results[nresults++];
+		memset(r, 0, sizeof(*r));
+		r->h = h;
+		pass.h = h;
+
+		/* throughput of hashing alone, the corpus is hot after counting. */
+		static volatile uint64_t sink;
+		double t0 = now();
+		sink += run(&pass, PASS_HASH, nthreads);
+		double elapsed = now() - t0;
+		r->ns_per_key = elapsed * nthreads * 1e9 / nkeys;
+		r->gb_per_s = corpus.size / elapsed / 1e9;
+
+		rezero(pass.seen, seen_bytes);
+		rezero(pass.buckets, size * sizeof(*pass.buckets));
+		r->collisions = run(&pass, PASS_STATS, nthreads);
+		r->expected_collisions = random_collisions((double)nkeys, 4294967296.0);
+		table_stats(pass.buckets, size, in_table, r);
+		r->avalanche_bias = avalanche(h, samples, nsamples);
+
+		if (!json) {
+			printf("%s,%u,%" PRIu64 ",%.1f,%.4f,%.4f,%.4f,%.4f,%.3f,%.3f\n",
+				h->name, h->wide ? 64 : 32, r->collisions, r->expected_collisions,
+				r->load_variance, r->variance_ratio, r->probe_length, r->avalanche_bias,
+				r->ns_per_key, r->gb_per_s);
+			fflush(stdout);
+		}
+	}
+
+	if (!nresults) {
+		fprintf(stderr, "hashsel: no function matches %s\n", only_fn);
+		return 2;
+	}
+
+	const char * why = NULL;
+	const struct result * pick = recommend(results, nresults, &why);
+
+	if (json) {
+		printf("{\"keys\": %" PRIu64 ", \"bytes\": %zu, \"table_buckets\": %" PRIu64 ", \"table_keys\": %" PRIu64 ", "
+			"\"threads\": %u, \"results\": [\n", nkeys, corpus.size, size, in_table, nthreads);
+		for (size_t i = 0; i < nresults; ++i) {
+			const struct result * r = &results[i];
+			printf("%s  {\"function\": \"%s\", \"bits\": %u, \"collisions\": %" PRIu64 ", "
+				"\"expected_collisions\": %.1f, \"load_variance\": %.4f, \"variance_ratio\": %.4f, "
+				"\"probe_length\": %.4f, \"avalanche_bias\": %.4f, \"ns_per_key\": %.3f, \"gb_per_s\": %.3f}",
+				i ? ",\n" : "", r->h->name, r->h->wide ? 64 : 32, r->collisions,
+				r->expected_collisions, r->load_variance, r->variance_ratio,
+				r->probe_length, r->avalanche_bias, r->ns_per_key, r->gb_per_s);
+		}
+		printf("\n], \"recommendation\": {\"function\": \"%s\", \"reason\": \"%s\"}}\n", pick->h->name, why);
+	}
+	else {
+		printf("# recommendation: %s, %s\n", pick->h->name, why);
+	}
+
+	munmap(pass.seen, seen_bytes);
+	munmap(pass.buckets, size * sizeof(*pass.buckets));
+	if (corpus.size) {
+		munmap((void *)corpus.base, corpus.size);
+	}
+	free(results);
+	free(samples);
+	free(pass.chunks);
+	return 0;
+}
+
+/* vim: set ts=4 tw=78 noet: */
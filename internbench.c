@@ -0,0 +1,244 @@
+/*****************************************************************************
+ * Copyright (C) 2020 Alexander Potylitsin <apotyn@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ *
+ ****************************************************************************/
+
+/*****************************************************************************
+ * internbench: scaling of strhash-intern.c over threads
+ *
+ * Measures, for 1, 2, 4 ... threads up to the online cores:
+ *   insert       threads intern disjoint slices of the keys into an empty table
+ *   find         every thread looks up all keys, hashing them
+ *   find_hashed  the same with hashes computed beforehand, as folded ones are
+ * Results are printed as CSV, best of three runs.
+ *
+ * usage: internbench [-n keys] [-j max threads]
+ ****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "hashfns.h"
+#include "strhash-intern.h"
+
+
+enum op { OP_INSERT, OP_FIND, OP_FIND_HASHED };
+
+static const char * const op_names[] = { "insert", "find", "find_hashed" };
+
+struct keyset {
+	char * arena;
+	const char ** keys;
+	size_t * lens;
+	uint32_t * hashes;
+	size_t n;
+};
+
+static uint64_t rng_state = 0x9E3779B97F4A7C15ULL;
+
+static uint64_t rng(void) {
+	/* xorshift64* */
+	rng_state ^= rng_state >> 12;
+	rng_state ^= rng_state << 25;
+	rng_state ^= rng_state >> 27;
+	return rng_state * 0x2545F4914F6CDD1DULL;
+}
+
+/* identifier like keys of 4 to 24 bytes, distinct by their numeric suffix */
+static void keyset_init(struct keyset * ks, size_t n) {
+	static const char alphabet[] = "abcdefghijklmnopqrstuvwxyz_";
+
+	ks->arena = malloc(n * 40);
+	ks->keys = malloc(n * sizeof(*ks->keys));
+	ks->lens = malloc(n * sizeof(*ks->lens));
+	ks->hashes = malloc(n * sizeof(*ks->hashes));
+	if (!ks->arena || !ks->keys || !ks->lens || !ks->hashes) {
+		fprintf(stderr, "internbench: out of memory\n");
+		exit(2);
+	}
+
+	char * p = ks->arena;
+	for (size_t i = 0; i < n; ++i) {
+		size_t len = rng() % 14;
+		for (size_t j = 0; j < len; ++j) {
+			p[j] = alphabet[rng() % (sizeof(alphabet) - 1)];
+		}
+		len += (size_t)sprintf(p + len, "%zx", i);
+		ks->keys[i] = p;
+		ks->lens[i] = len;
+		ks->hashes[i] = fnv1a_hash_n(p, len);
+		p += len + 1;
+	}
+	ks->n = n;
+}
+
+static void keyset_free(struct keyset * ks) {
+	free(ks->arena);
+	free(ks->keys);
+	free(ks->lens);
+	free(ks->hashes);
+}
+
+static double now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+struct worker {
+	pthread_t thread;
+	enum op op;
+	struct strhash_intern * tab;
+	const struct keyset * ks;
+	pthread_barrier_t * start;
+	unsigned int id;
+	unsigned int nthreads;
+	size_t misses;
+};
+
+static void * worker_run(void * arg) {
+	struct worker * w = arg;
+	const struct keyset * ks = w->ks;
+	size_t misses = 0;
+
+	pthread_barrier_wait(w->start);
+	switch (w->op) {
+		case OP_INSERT:
+			for (size_t i = w->id; i < ks->n; i += w->nthreads) {
+				misses += !strhash_intern_hashed(w->tab, ks->hashes[i], ks->keys[i], ks->lens[i]);
+			}
+			break;
+		case OP_FIND:
+			/* threads start apart so they do not walk the same lines in step */
+			for (size_t k = 0, i = ks->n / w->nthreads * w->id; k < ks->n; ++k, i = (i + 1 < ks->n) ? i + 1 : 0) {
+				misses += !strhash_intern_find(w->tab, ks->keys[i], ks->lens[i]);
+			}
+			break;
+		case OP_FIND_HASHED:
+			for (size_t k = 0, i = ks->n / w->nthreads * w->id; k < ks->n; ++k, i = (i + 1 < ks->n) ? i + 1 : 0) {
+				misses += !strhash_intern_find_hashed(w->tab, ks->hashes[i], ks->keys[i], ks->lens[i]);
+			}
+			break;
+	}
+	w->misses = misses;
+	return NULL;
+}
+
+/* seconds for nthreads threads running op, counts lookups that failed. */
+static double run(enum op op, struct strhash_intern * tab, const struct keyset * ks, unsigned int nthreads, size_t * misses) {
+	struct worker * w = calloc(nthreads, sizeof(*w));
+	pthread_barrier_t start;
+
+	pthread_barrier_init(&start, NULL, nthreads + 1);
+	for (unsigned int t = 0; t < nthreads; ++t) {
+		w[t].op = op;
+		w[t].tab = tab;
+		w[t].ks = ks;
+		w[t].start = &start;
+		w[t].id = t;
+		w[t].nthreads = nthreads;
+		pthread_create(&w[t].thread, NULL, worker_run, &w[t]);
+	}
+
+	double t0 = now();
+	pthread_barrier_wait(&start);
+	for (unsigned int t = 0; t < nthreads; ++t) {
+		pthread_join(w[t].thread, NULL);
+		*misses += w[t].misses;
+	}
+	double elapsed = now() - t0;
+
+	pthread_barrier_destroy(&start);
+	free(w);
+	return elapsed;
+}
+
+static struct strhash_intern * table_new(void) {
+	struct strhash_intern * tab = strhash_intern_new(fnv1a_hash_n, 0);
+	if (!tab) {
+		fprintf(stderr, "internbench: out of memory\n");
+		exit(2);
+	}
+	return tab;
+}
+
+int main(int argc, char ** argv) {
+	size_t nkeys = 1 << 20;
+	long max_threads = sysconf(_SC_NPROCESSORS_ONLN);
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:j:")) != -1) {
+		switch (opt) {
+			case 'n': nkeys = (size_t)atol(optarg); break;
+			case 'j': max_threads = atol(optarg); break;
+			default:
+				fprintf(stderr, "usage: %s [-n keys] [-j max threads]\n", argv[0]);
+				return 2;
+		}
+	}
+	if (max_threads < 1) {
+		max_threads = 1;
+	}
+
+	struct keyset ks;
+	keyset_init(&ks, nkeys ? nkeys : 1);
+
+	/* the table looked up by the find runs */
+	struct strhash_intern * full = table_new();
+	size_t misses = 0;
+	run(OP_INSERT, full, &ks, 1, &misses);
+
+	printf("op,threads,keys,ns_per_op,mops_per_s\n");
+	for (unsigned int nthreads = 1; ; nthreads *= 2) {
+		if (nthreads > max_threads) {
+			nthreads = (unsigned int)max_threads;
+		}
+		for (enum op op = OP_INSERT; op <= OP_FIND_HASHED; ++op) {
+			double best = 0;
+			for (int i = 0; i < 3; ++i) {
+				struct strhash_intern * tab = (OP_INSERT == op) ? table_new() : full;
+				double t = run(op, tab, &ks, nthreads, &misses);
+				if (i == 0 || t < best) best = t;
+				if (tab != full) {
+					strhash_intern_free(tab);
+				}
+			}
+
+			/* inserts split the keys between threads, lookups repeat them */
+			const double ops = (double)ks.n * (OP_INSERT == op ? 1 : nthreads);
+			printf("%s,%u,%zu,%.3f,%.3f\n", op_names[op], nthreads, ks.n,
+				best * 1e9 / ops * nthreads, ops / best / 1e6);
+			fflush(stdout);
+		}
+		if (nthreads == (unsigned int)max_threads) {
+			break;
+		}
+	}
+
+	if (misses) {
+		fprintf(stderr, "internbench: %zu keys not found\n", misses);
+	}
+	strhash_intern_free(full);
+	keyset_free(&ks);
+	return misses ? 1 : 0;
+}
+
+/* vim: set ts=4 tw=78 noet: */
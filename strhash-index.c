@@ -0,0 +1,160 @@
+/*****************************************************************************
+ * Copyright (C) 2020 Alexander Potylitsin <apotyn@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ *
+ ****************************************************************************/
+
+#include <errno.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "strhash-index.h"
+
+
+static const struct strhash_index_header * header(const struct strhash_index * idx) {
+	return (const struct strhash_index_header *)idx->base;
+}
+
+static const uint32_t * radix(const struct strhash_index * idx, const struct strhash_index_func * fn) {
+	const struct strhash_index_func * funcs =
+		(const struct strhash_index_func *)(idx->base + header(idx)->funcs_offset);
+	const uint32_t * tab = (const uint32_t *)(idx->base + header(idx)->radix_offset);
+	return tab + (size_t)(fn - funcs) * (STRHASH_INDEX_RADIX + 1);
+}
+
+static int section_fits(uint64_t offset, uint64_t count, uint64_t size, size_t file_size) {
+	return offset <= file_size && count <= (file_size - offset) / size;
+}
+
+static int valid(const struct strhash_index * idx) {
+	const struct strhash_index_header * hdr = header(idx);
+	if (idx->size < sizeof(*hdr) ||
+		memcmp(hdr->magic, STRHASH_INDEX_MAGIC, sizeof(hdr->magic)) != 0 ||
+		hdr->byte_order != STRHASH_INDEX_BYTE_ORDER) {
+		return 0;
+	}
+	if (!section_fits(hdr->funcs_offset, hdr->nfuncs, sizeof(struct strhash_index_func), idx->size) ||
+		!section_fits(hdr->radix_offset, (uint64_t)hdr->nfuncs * (STRHASH_INDEX_RADIX + 1), sizeof(uint32_t), idx->size) ||
+		!section_fits(hdr->entries_offset, hdr->nentries, sizeof(struct strhash_index_entry), idx->size) ||
+		!section_fits(hdr->strings_offset, hdr->strings_size, 1, idx->size) ||
+		hdr->strings_size == 0 ||
+		idx->base[hdr->strings_offset + hdr->strings_size - 1] != 0) {
+		return 0;
+	}
+
+	const struct strhash_index_func * funcs =
+		(const struct strhash_index_func *)(idx->base + hdr->funcs_offset);
+	for (uint32_t i = 0; i < hdr->nfuncs; ++i) {
+		if (funcs[i].name >= hdr->strings_size ||
+			(funcs[i].bits != 32 && funcs[i].bits != 64) ||
+			funcs[i].first > hdr->nentries || funcs[i].count > hdr->nentries - funcs[i].first) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+int strhash_index_open(struct strhash_index * idx, const char * path) {
+	struct stat st;
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		return -1;
+	}
+	if (fstat(fd, &st) < 0) {
+		int err = errno;
+		close(fd);
+		errno = err;
+		return -1;
+	}
+
+	void * base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (MAP_FAILED == base) {
+		return -1;
+	}
+
+	idx->base = (const unsigned char *)base;
+	idx->size = (size_t)st.st_size;
+	if (!valid(idx)) {
+		strhash_index_close(idx);
+		errno = EINVAL;
+		return -1;
+	}
+	return 0;
+}
+
+void strhash_index_close(struct strhash_index * idx) {
+	if (idx->base) {
+		munmap((void *)idx->base, idx->size);
+	}
+	idx->base = NULL;
+	idx->size = 0;
+}
+
+const struct strhash_index_func * strhash_index_func(const struct strhash_index * idx, const char * name) {
+	const struct strhash_index_header * hdr = header(idx);
+	const struct strhash_index_func * funcs =
+		(const struct strhash_index_func *)(idx->base + hdr->funcs_offset);
+	for (uint32_t i = 0; i < hdr->nfuncs; ++i) {
+		if (strcmp(strhash_index_string(idx, funcs[i].name), name) == 0) {
+			return &funcs[i];
+		}
+	}
+	return NULL;
+}
+
+size_t strhash_index_find(const struct strhash_index * idx, const struct strhash_index_func * fn,
+	uint64_t value, const struct strhash_index_entry ** first) {
+
+	const struct strhash_index_entry * entries =
+		(const struct strhash_index_entry *)(idx->base + header(idx)->entries_offset) + fn->first;
+	const uint32_t * buckets = radix(idx, fn);
+	const uint32_t k = strhash_index_bucket(value, fn->bits);
+
+	/* binary search for the lower bound within the radix bucket. */
+	size_t lo = buckets[k], hi = buckets[k + 1];
+	if (hi > fn->count || lo > hi) {
+		return 0;
+	}
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		if (entries[mid].value < value) {
+			lo = mid + 1;
+		}
+		else {
+			hi = mid;
+		}
+	}
+
+	size_t n = 0;
+	while (lo + n < buckets[k + 1] && entries[lo + n].value == value) {
+		++n;
+	}
+	*first = n ? &entries[lo] : NULL;
+	return n;
+}
+
+const char * strhash_index_string(const struct strhash_index * idx, uint32_t offset) {
+	const struct strhash_index_header * hdr = header(idx);
+	if (offset >= hdr->strings_size) {
+		return "";
+	}
+	return (const char *)(idx->base + hdr->strings_offset + offset);
+}
+
+/* vim: set ts=4 tw=78 noet: */
@@ -0,0 +1,105 @@
+/*****************************************************************************
+ * Copyright (C) 2020 Alexander Potylitsin <apotyn@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ *
+ ****************************************************************************/
+
+#ifndef STRHASH_INDEX_H
+#define STRHASH_INDEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cpluplus
+extern "C" {
+#endif
+
+/*****************************************************************************
+ * hash value to string index
+ *
+ * Written by strhash-manifest from the manifests of folded hash calls and
+ * meant to be mapped into memory as is. The file holds, in native byte
+ * order:
+ *
+ *   header
+ *   funcs[nfuncs]                    sorted by name
+ *   radix[nfuncs][STRHASH_INDEX_RADIX + 1]
+ *   entries[nentries]                grouped by function, sorted by value
+ *   strings                          NUL-terminated string pool
+ *
+ * radix[f][k] is the first entry of function f, relative to funcs[f].first,
+ * whose value has k in its top 16 bits.
+ ****************************************************************************/
+
+#define STRHASH_INDEX_MAGIC "STRHIDX1"
+#define STRHASH_INDEX_BYTE_ORDER 0x01020304U
+#define STRHASH_INDEX_RADIX_BITS 16
+#define STRHASH_INDEX_RADIX (1U << STRHASH_INDEX_RADIX_BITS)
+
+struct strhash_index_header {
+	char magic[8];
+	uint32_t byte_order;
+	uint32_t nfuncs;
+	uint64_t nentries;
+	uint64_t funcs_offset;
+	uint64_t radix_offset;
+	uint64_t entries_offset;
+	uint64_t strings_offset;
+	uint64_t strings_size;
+};
+
+struct strhash_index_func {
+	uint32_t name;			/* string pool offset */
+	uint32_t bits;			/* 32 or 64 */
+	uint64_t first;
+	uint64_t count;
+};
+
+struct strhash_index_entry {
+	uint64_t value;
+	uint32_t str;			/* string pool offset */
+	uint32_t len;			/* may contain NULs */
+};
+
+struct strhash_index {
+	const unsigned char * base;
+	size_t size;
+};
+
+/* maps the index file, returns 0 or -1 with errno set. */
+int strhash_index_open(struct strhash_index * idx, const char * path);
+void strhash_index_close(struct strhash_index * idx);
+
+/* returns the function hashed with name or NULL. */
+const struct strhash_index_func * strhash_index_func(const struct strhash_index * idx, const char * name);
+
+/* returns how many strings hash to value and the first of them. */
+size_t strhash_index_find(const struct strhash_index * idx, const struct strhash_index_func * fn,
+	uint64_t value, const struct strhash_index_entry ** first);
+
+const char * strhash_index_string(const struct strhash_index * idx, uint32_t offset);
+
+/* the radix bucket of value in a bits wide hash */
+static inline uint32_t strhash_index_bucket(uint64_t value, uint32_t bits) {
+	return (uint32_t)(value >> (bits - STRHASH_INDEX_RADIX_BITS)) & (STRHASH_INDEX_RADIX - 1);
+}
+
+#ifdef __cpluplus
+}
+#endif
+
+#endif /* #ifndef STRHASH_INDEX_H */
+
+/* vim: set ts=4 tw=78 noet: */
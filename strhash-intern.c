@@ -0,0 +1,380 @@
+/*****************************************************************************
+ * Copyright (C) 2020 Alexander Potylitsin <apotyn@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ *
+ ****************************************************************************/
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#if defined(__SSE2__)
+#	include <emmintrin.h>
+#endif
+
+#include "strhash-intern.h"
+#include "strhash-mph.h"
+
+
+/*****************************************************************************
+ * layout
+ *
+ * Each shard is an open addressing table of groups of 16 slots. A slot
+ * holds a pointer to its entry and a tag byte, 0x80 | 7 bits of the mixed
+ * hash, 0 when empty; the 16 tags of a group are two 64-bit words compared
+ * at once, so most probes touch one cache line of tags and read only the
+ * entries whose tag matches. Groups are probed triangularly and the table
+ * doubles before it is 7/8 full, so a probe always ends at a group with an
+ * empty slot.
+ *
+ * Writers fill the slot, then publish the tag word with a release store;
+ * readers load tag words with acquire and so see the slot of every tag
+ * they match. Slots are never emptied. A grown table is published the same
+ * way and the old one is kept for readers still probing it until the
+ * whole table is freed, which costs at most the size of the current one.
+ *
+ * Entries are bump allocated from chunks owned by the shard, under its
+ * lock, and never move.
+ ****************************************************************************/
+
+#define SHARD_BITS 6
+#define NSHARDS (1U << SHARD_BITS)
+#define GROUP 16
+#define CHUNK_BYTES (64 * 1024)
+
+#define TAG(m) ((uint8_t)(0x80U | ((m) & 0x7FU)))
+
+struct entry {
+	size_t len;
+	uint32_t hash;
+	char bytes[];
+};
+
+struct table {
+	size_t mask;				/* groups - 1 */
+	uint64_t * tags;			/* two words per group */
+	struct entry ** slots;
+	struct table * retired;		/* the table this one replaced */
+};
+
+struct chunk {
+	struct chunk * next;
+	size_t used;
+	size_t size;
+	char data[];
+};
+
+struct shard {
+	struct table * table;
+	pthread_mutex_t lock;
+	size_t count;
+	size_t limit;				/* count that triggers growth */
+	struct chunk * chunks;
+} __attribute__((aligned(64)));
+
+struct strhash_intern {
+	unsigned int (* hash)(const void *, size_t);
+	struct shard shards[NSHARDS];
+};
+
+
+/*****************************************************************************
+ * tag matching
+ ****************************************************************************/
+
+/* bit i set for every slot i of the group whose tag is tag */
+#if defined(__SSE2__)
+
+static inline unsigned int group_match(uint64_t lo, uint64_t hi, uint8_t tag) {
+	const __m128i tags = _mm_set_epi64x((long long)hi, (long long)lo);
+	return (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(tags, _mm_set1_epi8((char)tag)));
+}
+
+#else
+
+#define ONES 0x0101010101010101ULL
+#define LOWS 0x7F7F7F7F7F7F7F7FULL
+
+/* 0x80 in every zero byte of w, exact unlike the usual haszero() */
+static inline uint64_t zero_bytes(uint64_t w) {
+	return ~(((w & LOWS) + LOWS) | w | LOWS);
+}
+
+/* gathers the top bit of byte i into bit i */
+static inline unsigned int byte_bits(uint64_t m) {
+	return (unsigned int)(((m >> 7) * 0x0102040810204080ULL) >> 56);
+}
+
+static inline unsigned int group_match(uint64_t lo, uint64_t hi, uint8_t tag) {
+	const uint64_t t = tag * ONES;
+	return byte_bits(zero_bytes(lo ^ t)) | byte_bits(zero_bytes(hi ^ t)) << 8;
+}
+
+#endif
+
+
+/*****************************************************************************
+ * tables
+ ****************************************************************************/
+
+static struct table * table_new(size_t ngroups) {
+	struct table * tab = malloc(sizeof(*tab));
+	if (!tab) {
+		return NULL;
+	}
+	tab->mask = ngroups - 1;
+	tab->tags = calloc(ngroups * 2, sizeof(uint64_t));
+	tab->slots = calloc(ngroups * GROUP, sizeof(struct entry *));
+	tab->retired = NULL;
+	if (!tab->tags || !tab->slots) {
+		free(tab->tags);
+		free(tab->slots);
+		free(tab);
+		return NULL;
+	}
+	return tab;
+}
+
+static void table_free(struct table * tab) {
+	while (tab) {
+		struct table * retired = tab->retired;
+		free(tab->tags);
+		free(tab->slots);
+		free(tab);
+		tab = retired;
+	}
+}
+
+/* the group a probe starts at, from other bits than the shard and the tag */
+static inline size_t first_group(uint32_t m, size_t mask) {
+	return (size_t)((m * 0x9E3779B97F4A7C15ULL) >> 24) & mask;
+}
+
+static const struct entry * table_find(const struct table * tab, uint32_t m, uint32_t hash,
+	const void * p, size_t len) {
+
+	const uint8_t tag = TAG(m);
+	size_t g = first_group(m, tab->mask);
+	for (size_t step = 1; ; ++step) {
+		const uint64_t lo = __atomic_load_n(&tab->tags[2 * g], __ATOMIC_ACQUIRE);
+		const uint64_t hi = __atomic_load_n(&tab->tags[2 * g + 1], __ATOMIC_ACQUIRE);
+
+		for (unsigned int hits = group_match(lo, hi, tag); hits; hits &= hits - 1) {
+			const struct entry * e = __atomic_load_n(&tab->slots[g * GROUP + __builtin_ctz(hits)], __ATOMIC_RELAXED);
+			if (e->hash == hash && e->len == len && memcmp(e->bytes, p, len) == 0) {
+				return e;
+			}
+		}
+		if (group_match(lo, hi, 0)) {
+			return NULL;
+		}
+		g = (g + step) & tab->mask;
+	}
+}
+
+/* only under the shard lock, the entry must not be in the table */
+static void table_put(struct table * tab, struct entry * e) {
+	const uint32_t m = strhash_mph_mix(e->hash);
+	size_t g = first_group(m, tab->mask);
+	for (size_t step = 1; ; ++step) {
+		const uint64_t lo = __atomic_load_n(&tab->tags[2 * g], __ATOMIC_RELAXED);
+		const uint64_t hi = __atomic_load_n(&tab->tags[2 * g + 1], __ATOMIC_RELAXED);
+		const unsigned int empty = group_match(lo, hi, 0);
+		if (empty) {
+			const unsigned int i = (unsigned int)__builtin_ctz(empty);
+			uint64_t * word = &tab->tags[2 * g + i / 8];
+			__atomic_store_n(&tab->slots[g * GROUP + i], e, __ATOMIC_RELAXED);
+			__atomic_store_n(word, *word | (uint64_t)TAG(m) << (8 * (i % 8)), __ATOMIC_RELEASE);
+			return;
+		}
+		g = (g + step) & tab->mask;
+	}
+}
+
+static int shard_grow(struct shard * sh) {
+	struct table * old = sh->table;
+	struct table * tab = table_new((old->mask + 1) * 2);
+	if (!tab) {
+		return -1;
+	}
+	for (size_t i = 0; i < (old->mask + 1) * GROUP; ++i) {
+		if (old->slots[i]) {
+			table_put(tab, old->slots[i]);
+		}
+	}
+	tab->retired = old;
+	sh->limit = (tab->mask + 1) * GROUP / 8 * 7;
+	__atomic_store_n(&sh->table, tab, __ATOMIC_RELEASE);
+	return 0;
+}
+
+
+/*****************************************************************************
+ * arena
+ ****************************************************************************/
+
+static struct entry * shard_alloc(struct shard * sh, size_t len) {
+	const size_t align = sizeof(size_t);
+	const size_t size = (offsetof(struct entry, bytes) + len + 1 + align - 1) & ~(align - 1);
+	struct chunk * c = sh->chunks;
+
+	if (!c || c->size - c->used < size) {
+		/* large keys get a chunk of their own behind the current one */
+		const size_t csize = size > CHUNK_BYTES / 4 ? size : CHUNK_BYTES;
+		struct chunk * n = malloc(offsetof(struct chunk, data) + csize);
+		if (!n) {
+			return NULL;
+		}
+		n->used = 0;
+		n->size = csize;
+		if (c && csize != CHUNK_BYTES) {
+			n->next = c->next;
+			c->next = n;
+		}
+		else {
+			n->next = c;
+			sh->chunks = n;
+		}
+		c = n;
+	}
+
+	struct entry * e = (struct entry *)(c->data + c->used);
+	c->used += size;
+	return e;
+}
+
+
+/*****************************************************************************
+ * API
+ ****************************************************************************/
+
+static inline struct shard * shard_of(const struct strhash_intern * tab, uint32_t m) {
+	return (struct shard *)&tab->shards[m >> (32 - SHARD_BITS)];
+}
+
+struct strhash_intern * strhash_intern_new(unsigned int (* hash)(const void *, size_t), size_t expected) {
+	struct strhash_intern * tab;
+	if (posix_memalign((void **)&tab, 64, sizeof(*tab)) != 0) {
+		errno = ENOMEM;
+		return NULL;
+	}
+	memset(tab, 0, sizeof(*tab));
+	tab->hash = hash;
+
+	/* groups per shard to hold expected keys below the load limit */
+	size_t ngroups = 1;
+	while (ngroups * GROUP * NSHARDS / 8 * 7 < expected) {
+		ngroups *= 2;
+	}
+
+	for (unsigned int s = 0; s < NSHARDS; ++s) {
+		struct shard * sh = &tab->shards[s];
+		sh->table = table_new(ngroups);
+		sh->limit = ngroups * GROUP / 8 * 7;
+		if (!sh->table || pthread_mutex_init(&sh->lock, NULL) != 0) {
+			table_free(sh->table);
+			sh->table = NULL;
+			strhash_intern_free(tab);
+			errno = ENOMEM;
+			return NULL;
+		}
+	}
+	return tab;
+}
+
+void strhash_intern_free(struct strhash_intern * tab) {
+	if (!tab) {
+		return;
+	}
+	for (unsigned int s = 0; s < NSHARDS; ++s) {
+		struct shard * sh = &tab->shards[s];
+		if (!sh->table) {
+			break;
+		}
+		table_free(sh->table);
+		pthread_mutex_destroy(&sh->lock);
+		for (struct chunk * c = sh->chunks, * next; c; c = next) {
+			next = c->next;
+			free(c);
+		}
+	}
+	free(tab);
+}
+
+const char * strhash_intern_find_hashed(const struct strhash_intern * tab, uint32_t hash, const void * p, size_t len) {
+	const uint32_t m = strhash_mph_mix(hash);
+	const struct table * t = __atomic_load_n(&shard_of(tab, m)->table, __ATOMIC_ACQUIRE);
+	const struct entry * e = table_find(t, m, hash, p, len);
+	return e ? e->bytes : NULL;
+}
+
+const char * strhash_intern_find(const struct strhash_intern * tab, const void * p, size_t len) {
+	return strhash_intern_find_hashed(tab, tab->hash(p, len), p, len);
+}
+
+const char * strhash_intern_hashed(struct strhash_intern * tab, uint32_t hash, const void * p, size_t len) {
+	const uint32_t m = strhash_mph_mix(hash);
+	struct shard * sh = shard_of(tab, m);
+
+	/* most interned keys exist already, find them without the lock */
+	const struct entry * e = table_find(__atomic_load_n(&sh->table, __ATOMIC_ACQUIRE), m, hash, p, len);
+	if (e) {
+		return e->bytes;
+	}
+
+	pthread_mutex_lock(&sh->lock);
+	e = table_find(sh->table, m, hash, p, len);
+	if (!e) {
+		struct entry * n = NULL;
+		if (sh->count < sh->limit || shard_grow(sh) == 0) {
+			n = shard_alloc(sh, len);
+		}
+		if (n) {
+			n->len = len;
+			n->hash = hash;
+			memcpy(n->bytes, p, len);
+			n->bytes[len] = '\0';
+			table_put(sh->table, n);
+			__atomic_store_n(&sh->count, sh->count + 1, __ATOMIC_RELAXED);
+		}
+		e = n;
+	}
+	pthread_mutex_unlock(&sh->lock);
+
+	if (!e) {
+		errno = ENOMEM;
+		return NULL;
+	}
+	return e->bytes;
+}
+
+const char * strhash_intern(struct strhash_intern * tab, const void * p, size_t len) {
+	return strhash_intern_hashed(tab, tab->hash(p, len), p, len);
+}
+
+size_t strhash_intern_len(const char * s) {
+	return ((const struct entry *)(s - offsetof(struct entry, bytes)))->len;
+}
+
+size_t strhash_intern_count(const struct strhash_intern * tab) {
+	size_t n = 0;
+	for (unsigned int s = 0; s < NSHARDS; ++s) {
+		n += __atomic_load_n(&tab->shards[s].count, __ATOMIC_RELAXED);
+	}
+	return n;
+}
+
+/* vim: set ts=4 tw=78 noet: */
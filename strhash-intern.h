@@ -0,0 +1,79 @@
+/*****************************************************************************
+ * Copyright (C) 2020 Alexander Potylitsin <apotyn@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ *
+ ****************************************************************************/
+
+#ifndef STRHASH_INTERN_H
+#define STRHASH_INTERN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cpluplus
+extern "C" {
+#endif
+
+/*****************************************************************************
+ * concurrent string interning
+ *
+ * A table maps byte strings to a single copy of each, so interned strings
+ * compare equal by pointer. It hashes keys with one length-aware function
+ * of hashfns.h, and every call has a _hashed twin taking that hash from the
+ * caller: a literal hashed by the plugin costs no hashing at all,
+ *
+ *   const char * kw = STRHASH_INTERN_FIND(tab, fnv1a_hash, "while");
+ *
+ * becomes a constant hash, a tag probe and one memcmp.
+ *
+ * Lookups never lock and never write shared memory. Inserts lock one of
+ * 64 shards picked by the hash. Interned strings are NUL-terminated, may
+ * contain NULs and stay valid until strhash_intern_free().
+ ****************************************************************************/
+
+struct strhash_intern;
+
+/* returns a table sized for expected keys or NULL with errno set. */
+struct strhash_intern * strhash_intern_new(unsigned int (* hash)(const void *, size_t), size_t expected);
+void strhash_intern_free(struct strhash_intern * tab);
+
+/* returns the interned copy of len bytes at p, NULL with errno set when out of memory. */
+const char * strhash_intern(struct strhash_intern * tab, const void * p, size_t len);
+const char * strhash_intern_hashed(struct strhash_intern * tab, uint32_t hash, const void * p, size_t len);
+
+/* returns the interned copy or NULL, never inserts. */
+const char * strhash_intern_find(const struct strhash_intern * tab, const void * p, size_t len);
+const char * strhash_intern_find_hashed(const struct strhash_intern * tab, uint32_t hash, const void * p, size_t len);
+
+/* length of an interned string */
+size_t strhash_intern_len(const char * s);
+
+/* number of interned strings, exact when no insert runs concurrently. */
+size_t strhash_intern_count(const struct strhash_intern * tab);
+
+/* lookup of a literal, fn is the hash the table was created with */
+#define STRHASH_INTERN_FIND(tab, fn, lit) \
+	strhash_intern_find_hashed((tab), fn##_n(lit, sizeof(lit) - 1), (lit), sizeof(lit) - 1)
+
+#define STRHASH_INTERN(tab, fn, lit) \
+	strhash_intern_hashed((tab), fn##_n(lit, sizeof(lit) - 1), (lit), sizeof(lit) - 1)
+
+#ifdef __cpluplus
+}
+#endif
+
+#endif /* #ifndef STRHASH_INTERN_H */
+
+/* vim: set ts=4 tw=78 noet: */
@@ -0,0 +1,375 @@
+/*****************************************************************************
+ * Copyright (C) 2020 Alexander Potylitsin <apotyn@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ *
+ ****************************************************************************/
+
+/*****************************************************************************
+ * strhash-manifest: merges manifests written by the strhash plugin with
+ * -fplugin-arg-strhash-manifest=<file>, reports strings folding to the same
+ * value with the same hash function, and writes the value to string index
+ * described in strhash-index.h.
+ *
+ * usage: strhash-manifest [-k] [-o index] manifest...
+ *
+ * Exits with 1 when collisions are found unless -k is given.
+ ****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include "strhash-index.h"
+
+
+struct record {
+	char * fn;
+	uint32_t bits;
+	uint64_t value;
+	char * loc;
+	char * str;
+	size_t len;
+};
+
+static struct record * records = NULL;
+static size_t nrecords = 0;
+static size_t records_cap = 0;
+
+static void * xmalloc(size_t n) {
+	void * p = malloc(n ? n : 1);
+	if (!p) {
+		fprintf(stderr, "strhash-manifest: out of memory\n");
+		exit(2);
+	}
+	return p;
+}
+
+static char * xstrdup(const char * s) {
+	size_t n = strlen(s) + 1;
+	return memcpy(xmalloc(n), s, n);
+}
+
+static int hexdigit(int c) {
+	if (c >= '0' && c <= '9') return c - '0';
+	if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+	if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+	return -1;
+}
+
+/* reverts escaped() from gcc-log-utils.c in place, returns the length. */
+static size_t unescape(char * s) {
+	size_t p = 0;
+	for (size_t i = 0; s[i]; ++i) {
+		if (s[i] == '\\' && s[i + 1] == 'x' && hexdigit(s[i + 2]) >= 0 && hexdigit(s[i + 3]) >= 0) {
+			s[p++] = (char)(hexdigit(s[i + 2]) * 16 + hexdigit(s[i + 3]));
+			i += 3;
+		}
+		else {
+			s[p++] = s[i];
+		}
+	}
+	s[p] = 0;
+	return p;
+}
+
+/* fn \t bits \t value \t file:line \t escaped string */
+static bool parse_line(char * line, struct record * rec) {
+	char * field[5];
+	char * save = line;
+	for (int i = 0; i < 5; ++i) {
+		field[i] = save;
+		save = (i < 4) ? strchr(save, '\t') : NULL;
+		if (i < 4 && !save) return false;
+		if (save) *save++ = 0;
+	}
+
+	char * end;
+	rec->bits = (uint32_t)strtoul(field[1], &end, 10);
+	if (*end || (rec->bits != 32 && rec->bits != 64)) return false;
+	errno = 0;
+	rec->value = strtoull(field[2], &end, 16);
+	if (*end || errno) return false;
+
+	rec->fn = xstrdup(field[0]);
+	rec->loc = xstrdup(field[3]);
+	rec->str = xstrdup(field[4]);
+	rec->len = unescape(rec->str);
+	return true;
+}
+
+static bool read_manifest(const char * path) {
+	FILE * f = fopen(path, "r");
+	if (!f) {
+		fprintf(stderr, "strhash-manifest: %s: %s\n", path, strerror(errno));
+		return false;
+	}
+
+	char * line = NULL;
+	size_t cap = 0;
+	ssize_t n;
+	unsigned long lineno = 0;
+	while ((n = getline(&line, &cap, f)) > 0) {
+		++lineno;
+		if (line[n - 1] == '\n') line[--n] = 0;
+		if (n == 0) continue;
+
+		if (nrecords == records_cap) {
+			records_cap = records_cap ? 2 * records_cap : 1024;
+			records = realloc(records, records_cap * sizeof(*records));
+			if (!records) {
+				fprintf(stderr, "strhash-manifest: out of memory\n");
+				exit(2);
+			}
+		}
+		if (!parse_line(line, &records[nrecords])) {
+			fprintf(stderr, "strhash-manifest: %s:%lu: malformed record\n", path, lineno);
+			continue;
+		}
+		++nrecords;
+	}
+
+	free(line);
+	fclose(f);
+	return true;
+}
+
+static int compare_strings(const struct record * a, const struct record * b) {
+	size_t n = (a->len < b->len) ? a->len : b->len;
+	int r = memcmp(a->str, b->str, n);
+	return r ? r : (a->len > b->len) - (a->len < b->len);
+}
+
+static int compare_records(const void * pa, const void * pb) {
+	const struct record * a = pa;
+	const struct record * b = pb;
+	int r = strcmp(a->fn, b->fn);
+	if (r) return r;
+	if (a->value != b->value) return (a->value > b->value) ? 1 : -1;
+	return compare_strings(a, b);
+}
+
+/* sorts records and drops the same string folded in several places. */
+static void merge_records(void) {
+	size_t n = 0;
+	qsort(records, nrecords, sizeof(*records), compare_records);
+	for (size_t i = 0; i < nrecords; ++i) {
+		if (n > 0 && strcmp(records[n - 1].fn, records[i].fn) == 0 &&
+			records[n - 1].value == records[i].value &&
+			compare_strings(&records[n - 1], &records[i]) == 0) {
+			free(records[i].fn);
+			free(records[i].loc);
+			free(records[i].str);
+			continue;
+		}
+		records[n++] = records[i];
+	}
+	nrecords = n;
+}
+
+static void print_string(const struct record * rec) {
+	putchar('"');
+	for (size_t i = 0; i < rec->len; ++i) {
+		unsigned char c = (unsigned char)rec->str[i];
+		if (c >= 32 && c < 127 && c != '\\' && c != '"') {
+			putchar(c);
+		}
+		else {
+			printf("\\x%02x", c);
+		}
+	}
+	putchar('"');
+}
+
+/* prints a summary per hash function, returns the number of collisions. */
+static size_t report(void) {
+	size_t total = 0;
+	for (size_t i = 0; i < nrecords; ) {
+		size_t j = i, strings = 0, collisions = 0;
+		for (; j < nrecords && strcmp(records[j].fn, records[i].fn) == 0; ) {
+			size_t k = j + 1;
+			while (k < nrecords && strcmp(records[k].fn, records[j].fn) == 0 && records[k].value == records[j].value) {
+				++k;
+			}
+			if (k - j > 1) {
+				printf("%s: collision at 0x%llx:\n", records[j].fn, (unsigned long long)records[j].value);
+				for (size_t c = j; c < k; ++c) {
+					printf("\t");
+					print_string(&records[c]);
+					printf(" at %s\n", records[c].loc);
+				}
+				collisions += k - j - 1;
+			}
+			strings += k - j;
+			j = k;
+		}
+		printf("%s: %zu strings, %zu collisions\n", records[i].fn, strings, collisions);
+		total += collisions;
+		i = j;
+	}
+	return total;
+}
+
+static bool write_all(FILE * f, const void * p, size_t n) {
+	return fwrite(p, 1, n, f) == n;
+}
+
+static bool write_index(const char * path) {
+	struct strhash_index_header hdr;
+	size_t nfuncs = 0;
+
+	for (size_t i = 0; i < nrecords; ++i) {
+		if (i == 0 || strcmp(records[i - 1].fn, records[i].fn) != 0) {
+			++nfuncs;
+		}
+		else
+		if (records[i - 1].bits != records[i].bits) {
+			fprintf(stderr, "strhash-manifest: %s: inconsistent hash width\n", records[i].fn);
+			return false;
+		}
+	}
+
+	struct strhash_index_func * funcs = xmalloc(nfuncs * sizeof(*funcs));
+	uint32_t * buckets = xmalloc(nfuncs * (STRHASH_INDEX_RADIX + 1) * sizeof(*buckets));
+	struct strhash_index_entry * entries = xmalloc(nrecords * sizeof(*entries));
+	uint64_t pool = 0;
+
+	for (size_t i = 0, f = (size_t)-1; i < nrecords; ++i) {
+		if (i == 0 || strcmp(records[i - 1].fn, records[i].fn) != 0) {
+			++f;
+			funcs[f].name = (uint32_t)pool;
+			funcs[f].bits = records[i].bits;
+			funcs[f].first = i;
+			funcs[f].count = 0;
+			pool += strlen(records[i].fn) + 1;
+		}
+		entries[i].value = records[i].value;
+		entries[i].str = (uint32_t)pool;
+		entries[i].len = (uint32_t)records[i].len;
+		pool += records[i].len + 1;
+		++funcs[f].count;
+	}
+	if (pool > UINT32_MAX) {
+		fprintf(stderr, "strhash-manifest: %s: string pool exceeds 4GB\n", path);
+		return false;
+	}
+
+	/* bucket k starts at the first entry whose top bits are not below k. */
+	for (size_t f = 0; f < nfuncs; ++f) {
+		uint32_t * b = buckets + f * (STRHASH_INDEX_RADIX + 1);
+		const struct strhash_index_entry * e = entries + funcs[f].first;
+		uint64_t n = 0;
+		for (uint32_t k = 0; k <= STRHASH_INDEX_RADIX; ++k) {
+			while (n < funcs[f].count && strhash_index_bucket(e[n].value, funcs[f].bits) < k) {
+				++n;
+			}
+			b[k] = (uint32_t)n;
+		}
+	}
+
+	memset(&hdr, 0, sizeof(hdr));
+	memcpy(hdr.magic, STRHASH_INDEX_MAGIC, sizeof(hdr.magic));
+	hdr.byte_order = STRHASH_INDEX_BYTE_ORDER;
+	hdr.nfuncs = (uint32_t)nfuncs;
+	hdr.nentries = nrecords;
+	hdr.funcs_offset = sizeof(hdr);
+	hdr.radix_offset = hdr.funcs_offset + nfuncs * sizeof(*funcs);
+	hdr.entries_offset = hdr.radix_offset + nfuncs * (STRHASH_INDEX_RADIX + 1) * sizeof(*buckets);
+	hdr.entries_offset = (hdr.entries_offset + 7) & ~(uint64_t)7;
+	hdr.strings_offset = hdr.entries_offset + nrecords * sizeof(*entries);
+	hdr.strings_size = pool ? pool : 1;
+
+	/* write to a temporary and rename, readers may have the old one mapped. */
+	size_t tmplen = strlen(path) + 16;
+	char * tmp = xmalloc(tmplen);
+	snprintf(tmp, tmplen, "%s.%ld", path, (long)getpid());
+	FILE * out = fopen(tmp, "wb");
+	if (!out) {
+		fprintf(stderr, "strhash-manifest: %s: %s\n", tmp, strerror(errno));
+		return false;
+	}
+
+	static const char zeros[8];
+	bool ok = write_all(out, &hdr, sizeof(hdr)) &&
+		write_all(out, funcs, nfuncs * sizeof(*funcs)) &&
+		write_all(out, buckets, nfuncs * (STRHASH_INDEX_RADIX + 1) * sizeof(*buckets)) &&
+		write_all(out, zeros, hdr.entries_offset - (hdr.radix_offset + nfuncs * (STRHASH_INDEX_RADIX + 1) * sizeof(*buckets))) &&
+		write_all(out, entries, nrecords * sizeof(*entries));
+	for (size_t i = 0; ok && i < nrecords; ++i) {
+		if (i == 0 || strcmp(records[i - 1].fn, records[i].fn) != 0) {
+			ok = write_all(out, records[i].fn, strlen(records[i].fn) + 1);
+		}
+		ok = ok && write_all(out, records[i].str, records[i].len) && write_all(out, zeros, 1);
+	}
+	if (!pool) {
+		ok = ok && write_all(out, zeros, 1);
+	}
+	ok = (fclose(out) == 0) && ok;
+	if (!ok || rename(tmp, path) != 0) {
+		fprintf(stderr, "strhash-manifest: %s: %s\n", path, strerror(errno));
+		unlink(tmp);
+		ok = false;
+	}
+
+	free(tmp);
+	free(entries);
+	free(buckets);
+	free(funcs);
+	return ok;
+}
+
+int main(int argc, char ** argv) {
+	const char * index_path = NULL;
+	bool keep_going = false;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "ko:")) != -1) {
+		switch (opt) {
+			case 'k':
+				keep_going = true;
+				break;
+			case 'o':
+				index_path = optarg;
+				break;
+			default:
+				fprintf(stderr, "usage: %s [-k] [-o index] manifest...\n", argv[0]);
+				return 2;
+		}
+	}
+	if (optind >= argc) {
+		fprintf(stderr, "usage: %s [-k] [-o index] manifest...\n", argv[0]);
+		return 2;
+	}
+
+	for (int i = optind; i < argc; ++i) {
+		if (!read_manifest(argv[i])) {
+			return 2;
+		}
+	}
+
+	merge_records();
+	size_t collisions = report();
+
+	if (index_path && !write_index(index_path)) {
+		return 2;
+	}
+
+	return (collisions && !keep_going) ? 1 : 0;
+}
+
+/* vim: set ts=4 tw=78 noet: */
@@ -0,0 +1,48 @@
+/*****************************************************************************
+ * Copyright (C) 2020 Alexander Potylitsin <apotyn@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ *
+ ****************************************************************************/
+
+#include <string.h>
+
+#include "strhash-mph.h"
+
+
+int strhash_mph_find(const uint32_t * mph, unsigned int (* hash)(const char *),
+	const char * const * keys, const char * s) {
+
+	const uint32_t n = mph[0];
+	const uint32_t nbuckets = mph[1];
+	if (n == 0) {
+		return -1;
+	}
+
+	const uint32_t h = hash(s);
+	const uint32_t disp = mph[2 + strhash_mph_bucket(h, nbuckets)];
+	const uint32_t i = mph[2 + nbuckets + strhash_mph_slot(h, disp, n)];
+	return strcmp(keys[i], s) == 0 ? (int)i : -1;
+}
+
+int strhash_table_index(const char * const * keys, size_t n, const char * s) {
+	for (size_t i = 0; i < n; ++i) {
+		if (keys[i] && strcmp(keys[i], s) == 0) {
+			return (int)i;
+		}
+	}
+	return -1;
+}
+
+/* vim: set ts=4 tw=78 noet: */
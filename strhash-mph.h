@@ -0,0 +1,83 @@
+/*****************************************************************************
+ * Copyright (C) 2020 Alexander Potylitsin <apotyn@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ *
+ ****************************************************************************/
+
+#ifndef STRHASH_MPH_H
+#define STRHASH_MPH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cpluplus
+extern "C" {
+#endif
+
+/*****************************************************************************
+ * minimal perfect hash tables of string arrays
+ *
+ * The strhash plugin builds the table of a static array declared as
+ *   static const char * const keywords[] STRHASH_TABLE(fnv1a_hash) = { ... };
+ * at compile time, and rewrites strhash_table_index(keywords, n, s) calls
+ * on it to strhash_mph_find(). Without the plugin strhash_table_index()
+ * scans the array, so both give the same results.
+ *
+ * A table is an array of uint32_t, CHD style with one displacement per
+ * bucket of about four keys:
+ *
+ *   n, nbuckets
+ *   disp[nbuckets]
+ *   index[n]                         array position of the key in slot
+ *
+ * The key hashing to h lives in slot strhash_mph_slot(h, disp[b], n) with
+ * b = strhash_mph_bucket(h, nbuckets).
+ ****************************************************************************/
+
+#define STRHASH_TABLE(fn) __attribute__((strhash_table(fn)))
+
+/* murmur3 finalizer, spreads weak hashes over all bits */
+static inline uint32_t strhash_mph_mix(uint32_t x) {
+	x ^= x >> 16;
+	x *= 0x85ebca6bU;
+	x ^= x >> 13;
+	x *= 0xc2b2ae35U;
+	x ^= x >> 16;
+	return x;
+}
+
+static inline uint32_t strhash_mph_bucket(uint32_t hash, uint32_t nbuckets) {
+	return (uint32_t)(((uint64_t)strhash_mph_mix(hash) * nbuckets) >> 32);
+}
+
+static inline uint32_t strhash_mph_slot(uint32_t hash, uint32_t disp, uint32_t n) {
+	uint32_t x = strhash_mph_mix(hash + (disp + 1) * 0x9E3779B9U);
+	return (uint32_t)(((uint64_t)x * n) >> 32);
+}
+
+/* returns the position of s in keys or -1. */
+int strhash_mph_find(const uint32_t * mph, unsigned int (* hash)(const char *),
+	const char * const * keys, const char * s);
+
+/* returns the position of s in the first n keys or -1, NULL keys are skipped. */
+int strhash_table_index(const char * const * keys, size_t n, const char * s);
+
+#ifdef __cpluplus
+}
+#endif
+
+#endif /* #ifndef STRHASH_MPH_H */
+
+/* vim: set ts=4 tw=78 noet: */
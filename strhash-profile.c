@@ -0,0 +1,261 @@
+/*****************************************************************************
+ * Copyright (C) 2020 Alexander Potylitsin <apotyn@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ *
+ ****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "strhash-profile.h"
+
+
+/*****************************************************************************
+ * counters
+ *
+ * A site gets a number from 1 when first reached. Every thread owns the
+ * counters of the sites it reached, in chunks of CHUNK_SITES allocated on
+ * first use and never moved, one cache line pair per site so neighbouring
+ * sites of a thread do not share lines. Only the owner writes them; the
+ * report reads them with relaxed loads, so a thread still running at exit
+ * at most loses its last calls. Threads stay on the list after they end.
+ ****************************************************************************/
+
+#define CHUNK_SITES 64
+#define MAX_CHUNKS 1024
+
+struct counters {
+	uint64_t calls;
+	uint64_t cycles;
+	uint64_t lens[STRHASH_PROFILE_BUCKETS];
+} __attribute__((aligned(64)));
+
+struct thread_counters {
+	struct counters * chunks[MAX_CHUNKS];
+	struct thread_counters * next;
+};
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static const char ** site_names = NULL;
+static unsigned int nsites = 0;
+static unsigned int names_cap = 0;
+static struct thread_counters * threads = NULL;
+static __thread struct thread_counters * self = NULL;
+
+static void report_at_exit(void) {
+	strhash_profile_report();
+}
+
+/* numbers the site once, returns 0 when out of memory or numbers. */
+static unsigned int register_site(unsigned int * site, const char * name) {
+	pthread_mutex_lock(&lock);
+	unsigned int id = __atomic_load_n(site, __ATOMIC_RELAXED);
+	if (!id && nsites < CHUNK_SITES * MAX_CHUNKS) {
+		if (nsites == names_cap) {
+			unsigned int cap = names_cap ? 2 * names_cap : CHUNK_SITES;
+			const char ** names = realloc(site_names, cap * sizeof(*names));
+			if (names) {
+				site_names = names;
+				names_cap = cap;
+			}
+		}
+		if (nsites < names_cap) {
+			if (!nsites) {
+				atexit(report_at_exit);
+			}
+			site_names[nsites] = name;
+			id = ++nsites;
+			__atomic_store_n(site, id, __ATOMIC_RELEASE);
+		}
+	}
+	pthread_mutex_unlock(&lock);
+	return id;
+}
+
+static struct counters * site_counters(unsigned int id) {
+	struct thread_counters * tc = self;
+	if (!tc) {
+		tc = calloc(1, sizeof(*tc));
+		if (!tc) {
+			return NULL;
+		}
+		pthread_mutex_lock(&lock);
+		tc->next = threads;
+		threads = tc;
+		pthread_mutex_unlock(&lock);
+		self = tc;
+	}
+
+	const unsigned int i = (id - 1) / CHUNK_SITES;
+	struct counters * chunk = tc->chunks[i];
+	if (!chunk) {
+		if (posix_memalign((void **)&chunk, 64, CHUNK_SITES * sizeof(*chunk)) != 0) {
+			return NULL;
+		}
+		memset(chunk, 0, CHUNK_SITES * sizeof(*chunk));
+		__atomic_store_n(&tc->chunks[i], chunk, __ATOMIC_RELEASE);
+	}
+	return &chunk[(id - 1) % CHUNK_SITES];
+}
+
+static unsigned int len_bucket(size_t len) {
+	if (!len) {
+		return 0;
+	}
+	unsigned int b = 1 + (unsigned int)(8 * sizeof(unsigned long long) - 1 - __builtin_clzll(len));
+	return b < STRHASH_PROFILE_BUCKETS ? b : STRHASH_PROFILE_BUCKETS - 1;
+}
+
+static inline void bump(uint64_t * counter, uint64_t n) {
+	__atomic_store_n(counter, *counter + n, __ATOMIC_RELAXED);
+}
+
+/* time stamp counter where there is one, nanoseconds elsewhere */
+uint64_t strhash_profile_start(void) {
+#if defined(__x86_64__) || defined(__i386__)
+	return __builtin_ia32_rdtsc();
+#elif defined(__aarch64__)
+	uint64_t t;
+	__asm__ __volatile__("mrs %0, cntvct_el0" : "=r" (t));
+	return t;
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000U + ts.tv_nsec;
+#endif
+}
+
+void strhash_profile_stop(unsigned int * site, const char * name, const void * key, size_t len, uint64_t start) {
+	const uint64_t cycles = strhash_profile_start() - start;
+
+	unsigned int id = __atomic_load_n(site, __ATOMIC_ACQUIRE);
+	if (!id && !(id = register_site(site, name))) {
+		return;
+	}
+	struct counters * c = site_counters(id);
+	if (!c) {
+		return;
+	}
+
+	if (STRHASH_PROFILE_CSTR == len) {
+		len = strlen((const char *)key);
+	}
+	bump(&c->calls, 1);
+	bump(&c->cycles, cycles);
+	bump(&c->lens[len_bucket(len)], 1);
+}
+
+
+/*****************************************************************************
+ * report
+ ****************************************************************************/
+
+struct site_total {
+	const char * name;
+	struct counters sum;
+};
+
+static int by_cycles(const void * a, const void * b) {
+	const struct site_total * x = a;
+	const struct site_total * y = b;
+	if (x->sum.cycles != y->sum.cycles) {
+		return x->sum.cycles < y->sum.cycles ? 1 : -1;
+	}
+	return strcmp(x->name, y->name);
+}
+
+static void print_bucket(FILE * out, unsigned int b) {
+	if (b < 2) {
+		fprintf(out, "%u", b);
+	}
+	else
+	if (b == STRHASH_PROFILE_BUCKETS - 1) {
+		fprintf(out, "%lu+", 1UL << (b - 1));
+	}
+	else {
+		fprintf(out, "%lu-%lu", 1UL << (b - 1), (1UL << b) - 1);
+	}
+}
+
+void strhash_profile_report(void) {
+	pthread_mutex_lock(&lock);
+	const unsigned int n = nsites;
+	struct site_total * totals = calloc(n ? n : 1, sizeof(*totals));
+	if (!totals) {
+		pthread_mutex_unlock(&lock);
+		return;
+	}
+
+	uint64_t calls = 0, cycles = 0;
+	for (unsigned int id = 1; id <= n; ++id) {
+		struct site_total * t = &totals[id - 1];
+		t->name = site_names[id - 1];
+		for (struct thread_counters * tc = threads; tc; tc = tc->next) {
+			const struct counters * chunk = __atomic_load_n(&tc->chunks[(id - 1) / CHUNK_SITES], __ATOMIC_ACQUIRE);
+			if (!chunk) continue;
+			const struct counters * c = &chunk[(id - 1) % CHUNK_SITES];
+			t->sum.calls += __atomic_load_n(&c->calls, __ATOMIC_RELAXED);
+			t->sum.cycles += __atomic_load_n(&c->cycles, __ATOMIC_RELAXED);
+			for (unsigned int b = 0; b < STRHASH_PROFILE_BUCKETS; ++b) {
+				t->sum.lens[b] += __atomic_load_n(&c->lens[b], __ATOMIC_RELAXED);
+			}
+		}
+		calls += t->sum.calls;
+		cycles += t->sum.cycles;
+	}
+	pthread_mutex_unlock(&lock);
+
+	qsort(totals, n, sizeof(*totals), by_cycles);
+
+	const char * path = getenv("STRHASH_PROFILE");
+	FILE * out = (path && *path) ? fopen(path, "a") : stderr;
+	if (!out) {
+		out = stderr;
+	}
+
+	fprintf(out, "strhash profile: %u sites, %llu calls, %llu cycles\n",
+		n, (unsigned long long)calls, (unsigned long long)cycles);
+	fprintf(out, "%12s %14s %12s  %s\n", "calls", "cycles", "cycles/call", "site");
+	for (unsigned int i = 0; i < n; ++i) {
+		const struct site_total * t = &totals[i];
+		fprintf(out, "%12llu %14llu %12.1f  %s\n",
+			(unsigned long long)t->sum.calls, (unsigned long long)t->sum.cycles,
+			t->sum.calls ? (double)t->sum.cycles / t->sum.calls : 0.0, t->name);
+
+		/* the key length histogram, empty buckets left out */
+		bool first = true;
+		for (unsigned int b = 0; b < STRHASH_PROFILE_BUCKETS; ++b) {
+			if (!t->sum.lens[b]) continue;
+			fprintf(out, first ? "%41s len " : ", ", "");
+			print_bucket(out, b);
+			fprintf(out, ": %llu", (unsigned long long)t->sum.lens[b]);
+			first = false;
+		}
+		if (!first) {
+			fprintf(out, "\n");
+		}
+	}
+
+	if (out != stderr) {
+		fclose(out);
+	}
+	free(totals);
+}
+
+/* vim: set ts=4 tw=78 noet: */
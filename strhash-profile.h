@@ -0,0 +1,64 @@
+/*****************************************************************************
+ * Copyright (C) 2020 Alexander Potylitsin <apotyn@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ *
+ ****************************************************************************/
+
+#ifndef STRHASH_PROFILE_H
+#define STRHASH_PROFILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cpluplus
+extern "C" {
+#endif
+
+/*****************************************************************************
+ * runtime profile of hash call sites
+ *
+ * With the profile option the plugin surrounds every hash call it does not
+ * fold with
+ *
+ *   t = strhash_profile_start();
+ *   h = fnv1a_hash(s);
+ *   strhash_profile_stop(&site, "file.c:42: fnv1a_hash", s, (size_t)-1, t);
+ *
+ * where site is a static unsigned int of the call site, 0 until the site
+ * is first reached. Calls, cycles and a histogram of key lengths are
+ * counted per thread and per site, and merged into a report when the
+ * program exits: on stderr, or appended to the file named by the
+ * STRHASH_PROFILE environment variable.
+ ****************************************************************************/
+
+/* buckets of key lengths: 0, 1, 2-3, 4-7 ... 2048-4095, 4096 and more */
+#define STRHASH_PROFILE_BUCKETS 14
+
+/* a length of (size_t)-1 means the key is NUL-terminated */
+#define STRHASH_PROFILE_CSTR ((size_t)-1)
+
+uint64_t strhash_profile_start(void);
+void strhash_profile_stop(unsigned int * site, const char * name, const void * key, size_t len, uint64_t start);
+
+/* writes the report now, it is written at exit anyway. */
+void strhash_profile_report(void);
+
+#ifdef __cpluplus
+}
+#endif
+
+#endif /* #ifndef STRHASH_PROFILE_H */
+
+/* vim: set ts=4 tw=78 noet: */
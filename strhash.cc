@@ -21,6 +21,10 @@
 #include <stdarg.h>
 #include <string.h>
 #include <assert.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dlfcn.h>
+#include <sys/file.h>
 
 #include "gcc-common-header.h"
 #include "gcc-gimple-pass.h"
@@ -28,164 +32,2390 @@
 
 #include <function.h>
 #include <tree.h>
+#include <fold-const.h>
+#include <hash-map.h>
+#include <ggc.h>
 
 #include <gimple.h>
 #include <gimple-iterator.h>
 #include <gimple-expr.h>
 #include <gimple-walk.h>
+#include <gimple-fold.h>
+
+#include <basic-block.h>
+#include <cgraph.h>
+#include <rtl.h>
+#include <expr.h>
+#include <calls.h>
+#include <tree-cfg.h>
+#include <cfg.h>
+#include <cfghooks.h>
+#include <cfgloop.h>
+#include <dominance.h>
+#include <bitmap.h>
+#if BUILDING_GCC_VERSION >= 6000
+#	include <ssa.h>
+#else
+#	include <gimple-ssa.h>
+#	include <tree-ssanames.h>
+#	include <tree-ssa-operands.h>
+#	include <ssa-iterators.h>
+#endif
+#include <tree-into-ssa.h>
 
 #include <diagnostic.h>
+#include <dumpfile.h>
+#include <timevar.h>
+#include <options.h>
+#include <attribs.h>
+#include <toplev.h>
+#include <target.h>
+#include <langhooks.h>
+#include <output.h>
+#if BUILDING_GCC_VERSION >= 4009
+#	include <stringpool.h>
+#	include <varasm.h>
+#endif
+
+#include "hashfns.h"
+#include "strhash-mph.h"
+
+
+/*****************************************************************************
+ * plugin global state
+ ****************************************************************************/
+
+static const char * const version_string = "0.1";
+static const char * const help_string = "Compile-time string hashing support.";
+static const char * plugin_name = "";
+static bool enable_mismatch_args_warning = false;
+static bool enable_non_literal_arg_warning = false;
+static bool enable_call_replacement_warning = false;
+static bool enable_strcmp_switch = false;
+static const char * manifest_path = NULL;
+static const char * stats_path = NULL;
+static bool seed_given = false;
+static uint32_t seed_value = 0;
+static unsigned int inline_limit = 0;
+static bool enable_profile = false;
+
+/* what becomes of read-only arrays only passed to folded hash calls */
+enum literals_mode {
+	LITERALS_DROP,			/* removed from the object */
+	LITERALS_KEEP,			/* left to the compiler */
+	LITERALS_SECTION,		/* removed, folded strings go to STRHASH_LITERALS_SECTION */
+};
+static enum literals_mode literals_mode = LITERALS_DROP;
+
+
+/*****************************************************************************
+ * known hash functions
+ ****************************************************************************/
+
+enum hashfn_kind {
+	HASHFN_CSTR,			/* unsigned int fn(const char * s) */
+	HASHFN_MEM,				/* unsigned int fn(const void * p, size_t len) */
+	HASHFN_CSTR64,			/* uint64_t fn(const char * s) */
+	HASHFN_MEM64,			/* uint64_t fn(const void * p, size_t len) */
+	HASHFN_CSTR_SEEDED,		/* unsigned int fn(const char * s, uint32_t seed) */
+	HASHFN_SEED,			/* uint32_t strhash_seed(void), the seed= option */
+	HASHFN_INIT,			/* uint32_t fn(void) */
+	HASHFN_UPDATE,			/* uint32_t fn(uint32_t state, const void * p, size_t len) */
+	HASHFN_FINAL,			/* unsigned int fn(uint32_t state) */
+	HASHFN_TABLE_INDEX,		/* int strhash_table_index(keys, n, s) */
+};
+
+struct hashfn_desc {
+	const char * name;
+	enum hashfn_kind kind;
+	union {
+		unsigned int (* cstr)(const char *);
+		unsigned int (* mem)(const void *, size_t);
+		uint64_t (* cstr64)(const char *);
+		uint64_t (* mem64)(const void *, size_t);
+		unsigned int (* seeded)(const char *, uint32_t);
+		uint32_t (* seed)(void);
+		uint32_t (* init)(void);
+		uint32_t (* update)(uint32_t, const void *, size_t);
+		unsigned int (* final)(uint32_t);
+	} fn;
+};
+
+static unsigned int noop_hash(const char * s) {
+	return 0xdeadbeef;
+}
+
+#define HASHFN_ENTRY(f, k, member) \
+	{ .name = GCC_STRINGIFY(f), .kind = k, .fn = { .member = f } },
+
+static const struct hashfn_desc hashfn_table[] = {
+	HASHFN_ENTRY(noop_hash, HASHFN_CSTR, cstr)
+	HASHFN_ENTRY(strhash_seed, HASHFN_SEED, seed)
+	{ .name = "strhash_table_index", .kind = HASHFN_TABLE_INDEX, .fn = { .cstr = NULL } },
+#define HASHFN(f) HASHFN_ENTRY(f, HASHFN_CSTR, cstr)
+#define HASHFN_N(f) HASHFN_ENTRY(f, HASHFN_MEM, mem)
+#define HASHFN64(f) HASHFN_ENTRY(f, HASHFN_CSTR64, cstr64)
+#define HASHFN64_N(f) HASHFN_ENTRY(f, HASHFN_MEM64, mem64)
+#define HASHFN_SEEDED(f) HASHFN_ENTRY(f, HASHFN_CSTR_SEEDED, seeded)
+#define HASHFN_STREAM(f) \
+	HASHFN_ENTRY(f##_init, HASHFN_INIT, init) \
+	HASHFN_ENTRY(f##_update, HASHFN_UPDATE, update) \
+	HASHFN_ENTRY(f##_final, HASHFN_FINAL, final)
+#include "hashfns.def"
+};
+
+#undef HASHFN_ENTRY
+
+static bool hashfn_takes_length(const struct hashfn_desc * desc) {
+	return HASHFN_MEM == desc->kind || HASHFN_MEM64 == desc->kind || HASHFN_UPDATE == desc->kind;
+}
+
+static bool hashfn_takes_string(const struct hashfn_desc * desc) {
+	return HASHFN_SEED != desc->kind && HASHFN_INIT != desc->kind && HASHFN_FINAL != desc->kind;
+}
+
+/* index of the string argument, an update takes the state first. */
+static unsigned int hashfn_string_arg(const struct hashfn_desc * desc) {
+	return HASHFN_UPDATE == desc->kind ? 1 : 0;
+}
+
+static unsigned int hashfn_bits(const struct hashfn_desc * desc) {
+	return (HASHFN_CSTR64 == desc->kind || HASHFN_MEM64 == desc->kind) ? 64 : 32;
+}
+
+static unsigned int hashfn_nargs(const struct hashfn_desc * desc) {
+	switch (desc->kind) {
+		case HASHFN_SEED:
+		case HASHFN_INIT:
+			return 0;
+		case HASHFN_UPDATE:
+		case HASHFN_TABLE_INDEX:
+			return 3;
+		case HASHFN_MEM:
+		case HASHFN_MEM64:
+		case HASHFN_CSTR_SEEDED:
+			return 2;
+		default:
+			return 1;
+	}
+}
+
+/* the function type of the hashes taking a string, NULL_TREE for others. */
+static tree hashfn_type(const struct hashfn_desc * desc) {
+	tree cchar_ptr = build_pointer_type(build_qualified_type(char_type_node, TYPE_QUAL_CONST));
+	switch (desc->kind) {
+		case HASHFN_CSTR:
+			return build_function_type_list(unsigned_type_node, cchar_ptr, NULL_TREE);
+		case HASHFN_MEM:
+			return build_function_type_list(unsigned_type_node, const_ptr_type_node, size_type_node, NULL_TREE);
+		case HASHFN_CSTR64:
+			return build_function_type_list(uint64_type_node, cchar_ptr, NULL_TREE);
+		case HASHFN_MEM64:
+			return build_function_type_list(uint64_type_node, const_ptr_type_node, size_type_node, NULL_TREE);
+		case HASHFN_CSTR_SEEDED:
+			return build_function_type_list(unsigned_type_node, cchar_ptr, uint32_type_node, NULL_TREE);
+		default:
+			return NULL_TREE;
+	}
+}
+
+/* computes the hash of len bytes at str, wide enough for any kind; word is
+ * the seed of seeded hashes and the state passed to update and final. */
+static unsigned HOST_WIDE_INT eval_hashfn(const struct hashfn_desc * desc, const char * str, size_t len, uint32_t word) {
+	switch (desc->kind) {
+		case HASHFN_CSTR:
+			return desc->fn.cstr(str);
+		case HASHFN_MEM:
+			return desc->fn.mem(str, len);
+		case HASHFN_CSTR64:
+			return desc->fn.cstr64(str);
+		case HASHFN_MEM64:
+			return desc->fn.mem64(str, len);
+		case HASHFN_CSTR_SEEDED:
+			return desc->fn.seeded(str, word);
+		case HASHFN_SEED:
+			return seed_value;
+		case HASHFN_INIT:
+			return desc->fn.init();
+		case HASHFN_UPDATE:
+			return desc->fn.update(word, str, len);
+		case HASHFN_FINAL:
+			return desc->fn.final(word);
+		case HASHFN_TABLE_INDEX:
+			break;
+	}
+	gcc_unreachable();
+}
+
+/* the kind of hash taking a string fntype declares: a pointer, then a
+ * size_t length or a 32-bit seed, returning 32 or 64 unsigned bits. */
+static bool hashfn_type_kind(tree fntype, enum hashfn_kind * kind) {
+	if (!prototype_p(fntype)) {
+		return false;
+	}
+	tree ret = TREE_TYPE(fntype);
+	if (INTEGER_TYPE != TREE_CODE(ret) || !TYPE_UNSIGNED(ret) ||
+		(32 != TYPE_PRECISION(ret) && 64 != TYPE_PRECISION(ret))) {
+		return false;
+	}
+	const bool wide = 64 == TYPE_PRECISION(ret);
+
+	tree args = TYPE_ARG_TYPES(fntype);
+	if (!args || !POINTER_TYPE_P(TREE_VALUE(args))) {
+		return false;
+	}
+	args = TREE_CHAIN(args);
+	if (args == void_list_node) {
+		*kind = wide ? HASHFN_CSTR64 : HASHFN_CSTR;
+		return true;
+	}
+	if (!args || TREE_CHAIN(args) != void_list_node) {
+		return false;
+	}
+
+	/* the length wins where size_t is 32 bits wide as well. */
+	tree arg = TREE_VALUE(args);
+	if (INTEGER_TYPE != TREE_CODE(arg) || !TYPE_UNSIGNED(arg)) {
+		return false;
+	}
+	if (TYPE_PRECISION(arg) == TYPE_PRECISION(size_type_node)) {
+		*kind = wide ? HASHFN_MEM64 : HASHFN_MEM;
+		return true;
+	}
+	if (!wide && 32 == TYPE_PRECISION(arg)) {
+		*kind = HASHFN_CSTR_SEEDED;
+		return true;
+	}
+	return false;
+}
+
+/* shared libraries of the lib= option and the hashes found in them */
+static vec<void *> hashfn_libs = vNULL;
+static vec<struct hashfn_desc *> hashfn_lib_descs = vNULL;
+
+static bool load_hashfn_lib(const char * path) {
+	void * handle = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+	if (!handle) {
+		error("option %<-fplugin-arg-%s-lib%>: %s", plugin_name, dlerror());
+		return false;
+	}
+	hashfn_libs.safe_push(handle);
+	return true;
+}
+
+/* the hash called name of the given kind, one of hashfn_table or else the
+ * first one the lib= libraries export, NULL if none. */
+static const struct hashfn_desc * find_hashfn(const char * name, enum hashfn_kind kind) {
+	for (unsigned int i = 0; i < GCC_COUNTOF(hashfn_table); ++i) {
+		if (strcmp(hashfn_table[i].name, name) == 0) {
+			return kind == hashfn_table[i].kind ? &hashfn_table[i] : NULL;
+		}
+	}
+
+	unsigned int i;
+	struct hashfn_desc * desc;
+	FOR_EACH_VEC_ELT(hashfn_lib_descs, i, desc) {
+		if (strcmp(desc->name, name) == 0) {
+			return kind == desc->kind ? desc : NULL;
+		}
+	}
+
+	void * handle;
+	FOR_EACH_VEC_ELT(hashfn_libs, i, handle) {
+		void * sym = dlsym(handle, name);
+		if (!sym) continue;
+
+		desc = XCNEW(struct hashfn_desc);
+		desc->name = xstrdup(name);
+		desc->kind = kind;
+		switch (kind) {
+			case HASHFN_CSTR:
+				desc->fn.cstr = (unsigned int (*)(const char *))sym;
+				break;
+			case HASHFN_MEM:
+				desc->fn.mem = (unsigned int (*)(const void *, size_t))sym;
+				break;
+			case HASHFN_CSTR64:
+				desc->fn.cstr64 = (uint64_t (*)(const char *))sym;
+				break;
+			case HASHFN_MEM64:
+				desc->fn.mem64 = (uint64_t (*)(const void *, size_t))sym;
+				break;
+			case HASHFN_CSTR_SEEDED:
+				desc->fn.seeded = (unsigned int (*)(const char *, uint32_t))sym;
+				break;
+			default:
+				gcc_unreachable();
+		}
+		hashfn_lib_descs.safe_push(desc);
+		return desc;
+	}
+	return NULL;
+}
+
+
+/*****************************************************************************
+ * hash function declarations seen in the translation unit
+ *
+ * Every file scope function declaration or definition is matched by its
+ * identifier once, when the front end finishes it. Calls are then matched
+ * by their fndecl alone, and functions of translation units which never
+ * use a hash function are not scanned at all.
+ ****************************************************************************/
+
+/* identifier of every known hash function -> its descriptor */
+static hash_map<tree, const struct hashfn_desc *> * hashfn_names = NULL;
+
+/* declarations of known hash functions -> their descriptors */
+static hash_map<tree, const struct hashfn_desc *> * hashfn_decls = NULL;
+
+/* the same declarations kept alive for the garbage collector */
+static vec<tree, va_gc> * hashfn_decl_roots = NULL;
+
+static const struct ggc_root_tab strhash_ggc_roots[] = {
+	{ &hashfn_decl_roots, 1, sizeof(hashfn_decl_roots),
+		&gt_ggc_mx_vec_tree_va_gc_, &gt_pch_nx_vec_tree_va_gc_ },
+	LAST_GGC_ROOT_TAB
+};
+
+static const struct hashfn_desc * lookup_hashfn_decl(tree fndecl) {
+	if (!hashfn_decls) {
+		return NULL;
+	}
+	const struct hashfn_desc * const * desc = hashfn_decls->get(fndecl);
+	return desc ? *desc : NULL;
+}
+
+static void add_hashfn_decl(tree decl, const struct hashfn_desc * desc) {
+	if (!hashfn_decls) {
+		hashfn_decls = new hash_map<tree, const struct hashfn_desc *>;
+	}
+	if (!hashfn_decls->put(decl, desc)) {
+		vec_safe_push(hashfn_decl_roots, decl);
+	}
+}
+
+/* a declaration of the library function of desc, the one of the translation
+ * unit when it has one, otherwise an extern one with C linkage. */
+static tree hashfn_library_decl(const struct hashfn_desc * desc, tree type) {
+	unsigned int i;
+	tree decl;
+	FOR_EACH_VEC_SAFE_ELT(hashfn_decl_roots, i, decl) {
+		if (BUILT_IN_MD != DECL_BUILT_IN_CLASS(decl) && lookup_hashfn_decl(decl) == desc) {
+			return decl;
+		}
+	}
+
+	decl = build_fn_decl(desc->name, type);
+	SET_DECL_ASSEMBLER_NAME(decl, get_identifier(desc->name));
+	DECL_PURE_P(decl) = 1;
+	add_hashfn_decl(decl, desc);
+	return decl;
+}
+
+static bool decl_global_scope_p(tree decl) {
+	tree ctx = DECL_CONTEXT(decl);
+	/* C++ puts global functions into the global namespace. */
+	if (ctx && NAMESPACE_DECL == TREE_CODE(ctx)) {
+		return DECL_FILE_SCOPE_P(ctx);
+	}
+	return DECL_FILE_SCOPE_P(decl);
+}
+
+/* strhash("name") names the hash of a declaration explicitly, a known hash
+ * of hashfns.c or one exported by a lib= library, of the declared type. */
+static const struct hashfn_desc * strhash_attribute_hashfn(tree decl, tree args) {
+	tree name = args ? TREE_VALUE(args) : NULL_TREE;
+	enum hashfn_kind kind;
+	if (!name || STRING_CST != TREE_CODE(name) || !hashfn_type_kind(TREE_TYPE(decl), &kind)) {
+		return NULL;
+	}
+	return find_hashfn(TREE_STRING_POINTER(name), kind);
+}
+
+static tree handle_strhash_attribute(tree * node, tree name, tree args, int, bool * no_add_attrs) {
+	tree decl = *node;
+	enum hashfn_kind kind;
+
+	if (FUNCTION_DECL != TREE_CODE(decl)) {
+		warning(OPT_Wattributes, "%qE attribute only applies to functions", name);
+		*no_add_attrs = true;
+	}
+	else
+	if (!hashfn_type_kind(TREE_TYPE(decl), &kind)) {
+		warning(OPT_Wattributes, "%qE attribute ignored on %qD, not a hash of a string or of a length and a pointer", name, decl);
+		*no_add_attrs = true;
+	}
+	else
+	if (!strhash_attribute_hashfn(decl, args)) {
+		warning(OPT_Wattributes, "%qE attribute argument is not a hash function of the plugin or its libraries of the type of %qD", name, decl);
+		*no_add_attrs = true;
+	}
+	return NULL_TREE;
+}
+
+static struct attribute_spec strhash_attribute = {
+	.name = "strhash",
+	.min_length = 1,
+	.max_length = 1,
+	.decl_required = true,
+	.type_required = false,
+	.function_type_required = false,
+#if BUILDING_GCC_VERSION >= 8000
+	.affects_type_identity = false,
+	.handler = handle_strhash_attribute,
+	.exclude = NULL,
+#else
+	.handler = handle_strhash_attribute,
+	.affects_type_identity = false,
+#endif
+};
+
+/* without the attribute only public declarations of a known name whose
+ * type fits are hashes; static functions may share the names. */
+static const struct hashfn_desc * hashfn_of_decl(tree decl) {
+	tree attr = lookup_attribute("strhash", DECL_ATTRIBUTES(decl));
+	if (attr) {
+		return strhash_attribute_hashfn(decl, TREE_VALUE(attr));
+	}
+	if (!TREE_PUBLIC(decl) || !decl_global_scope_p(decl)) {
+		return NULL;
+	}
+
+	/* identifiers are never collected, so the map may keep them. */
+	if (!hashfn_names) {
+		hashfn_names = new hash_map<tree, const struct hashfn_desc *>;
+		for (unsigned int i = 0; i < GCC_COUNTOF(hashfn_table); ++i) {
+			hashfn_names->put(get_identifier(hashfn_table[i].name), &hashfn_table[i]);
+		}
+	}
+
+	const struct hashfn_desc * const * desc = hashfn_names->get(DECL_NAME(decl));
+	if (!desc) {
+		return NULL;
+	}
+	enum hashfn_kind kind;
+	if (hashfn_type(*desc) && (!hashfn_type_kind(TREE_TYPE(decl), &kind) || kind != (*desc)->kind)) {
+		return NULL;
+	}
+	return *desc;
+}
+
+static void track_hashfn_decl(tree decl) {
+	if (FUNCTION_DECL != TREE_CODE(decl) || !DECL_NAME(decl)) {
+		return;
+	}
+
+	const struct hashfn_desc * desc = hashfn_of_decl(decl);
+	if (desc) {
+		/* under -flto the calls are folded in LTRANS after cross unit
+		 * inlining, which must not inline the hash itself first. */
+		if (flag_lto && !in_lto_p) {
+			DECL_UNINLINABLE(decl) = 1;
+		}
+		add_hashfn_decl(decl, desc);
+	}
+}
+
+/* lto1 has no front end, the declarations come from the symbol table of
+ * the partition instead and the ones with callers count as used. */
+static void track_symtab_hashfn_decls(void) {
+	static bool tracked = false;
+	if (tracked) {
+		return;
+	}
+	tracked = true;
+
+	struct cgraph_node * node;
+	FOR_EACH_FUNCTION(node) {
+		track_hashfn_decl(node->decl);
+		if (node->callers && lookup_hashfn_decl(node->decl)) {
+			TREE_USED(node->decl) = 1;
+		}
+	}
+}
+
+/* true when some known hash function is referenced by the TU. */
+static bool hashfn_decls_used(void) {
+	unsigned int i;
+	tree decl;
+	FOR_EACH_VEC_SAFE_ELT(hashfn_decl_roots, i, decl) {
+		if (TREE_USED(decl)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static void strhash_finish_decl(void * gcc_data, void * user_data) {
+	track_hashfn_decl((tree)gcc_data);
+}
+
+
+/*****************************************************************************
+ * manifest of folded calls
+ *
+ * Every fold of the translation unit is buffered as a line of
+ *   fn \t bits \t value \t file:line \t escaped string
+ * and the whole buffer is appended to the manifest under an exclusive
+ * lock when compilation finishes, so parallel compilers never interleave
+ * their records. See strhash-manifest.c for the reader.
+ ****************************************************************************/
+
+static char * manifest_buf = NULL;
+static size_t manifest_len = 0;
+static size_t manifest_cap = 0;
+
+static void manifest_record(const struct hashfn_desc * desc, unsigned HOST_WIDE_INT hval,
+	const char * str, size_t len, location_t locus) {
+
+	if (!manifest_path && LITERALS_SECTION != literals_mode) {
+		return;
+	}
+
+	expanded_location xloc = expand_location(locus);
+	const char * file = xloc.file ? xloc.file : "";
+	size_t need = strlen(desc->name) + strlen(file) + 4 * len + 64;
+	if (manifest_cap - manifest_len < need) {
+		manifest_cap = MAX(2 * manifest_cap, manifest_len + need);
+		manifest_buf = XRESIZEVEC(char, manifest_buf, manifest_cap);
+	}
+
+	char * p = manifest_buf + manifest_len;
+	p += sprintf(p, "%s\t%u\t" HOST_WIDE_INT_PRINT_HEX "\t%s:%d\t",
+		desc->name, hashfn_bits(desc), hval, file, xloc.line);
+	p += escaped(p, 4 * len + 1, str, len);
+	*p++ = '\n';
+	manifest_len = p - manifest_buf;
+}
+
+/* appends len bytes at buf to the file at path under an exclusive lock. */
+static void append_locked(const char * path, const char * what, const char * buf, size_t len) {
+	int fd = open(path, O_WRONLY | O_CREAT | O_APPEND, 0666);
+	if (fd < 0) {
+		error("cannot open %s %qs: %m", what, path);
+		return;
+	}
+	if (flock(fd, LOCK_EX) < 0) {
+		error("cannot lock %s %qs: %m", what, path);
+		close(fd);
+		return;
+	}
+
+	for (size_t off = 0; off < len; ) {
+		ssize_t n = write(fd, buf + off, len - off);
+		if (n < 0) {
+			if (EINTR == errno) continue;
+			error("cannot write %s %qs: %m", what, path);
+			break;
+		}
+		off += n;
+	}
+
+	flock(fd, LOCK_UN);
+	close(fd);
+}
+
+static void manifest_flush(void * gcc_data, void * user_data) {
+	if (manifest_len) {
+		append_locked(manifest_path, "manifest", manifest_buf, manifest_len);
+		manifest_len = 0;
+	}
+}
+
+
+/*****************************************************************************
+ * cost and fold rate statistics
+ *
+ * Every pass execution is timed as the "strhash" client item of
+ * -ftime-report on top of the plugin timevar. With stats=<file> the
+ * counters of the translation unit are appended to the file as a line of
+ * JSON when compilation finishes.
+ ****************************************************************************/
+
+static struct {
+	unsigned long functions_scanned;
+	unsigned long functions_skipped;
+	unsigned long statements_scanned;
+	unsigned long calls_examined;
+	unsigned long calls_folded;
+	unsigned long skipped_non_literal;
+	unsigned long skipped_argument_count;
+	unsigned long skipped_unknown_function;
+	unsigned long strcmp_chains;
+	unsigned long strcmp_cases;
+	unsigned long tables_built;
+	unsigned long table_lookups;
+	unsigned long calls_inlined;
+	unsigned long calls_to_length;
+	unsigned long literals_dropped;
+	unsigned long calls_profiled;
+	long usec;
+} stats;
+
+static const char * const timer_item = "strhash";
+
+static long stats_timer_start(void) {
+#if BUILDING_GCC_VERSION >= 6000
+	if (g_timer) {
+		g_timer->push_client_item(timer_item);
+	}
+#endif
+	return stats_path ? get_run_time() : 0;
+}
+
+static void stats_timer_stop(long start) {
+	if (stats_path) {
+		stats.usec += get_run_time() - start;
+	}
+#if BUILDING_GCC_VERSION >= 6000
+	if (g_timer) {
+		g_timer->pop_client_item();
+	}
+#endif
+}
+
+static void stats_flush(void * gcc_data, void * user_data) {
+	const char * file = main_input_filename ? main_input_filename : "";
+	size_t len = strlen(file);
+	char * buf = XNEWVEC(char, 6 * len + 1024);
+	char * p = buf;
+
+	/* the file name as JSON string */
+	p += sprintf(p, "{\"file\": \"");
+	for (size_t i = 0; i < len; ++i) {
+		unsigned char c = (unsigned char)file[i];
+		if ('"' == c || '\\' == c) {
+			*p++ = '\\';
+			*p++ = c;
+		}
+		else
+		if (c < 32) {
+			p += sprintf(p, "\\u%04x", c);
+		}
+		else {
+			*p++ = c;
+		}
+	}
+
+	p += sprintf(p, "\", "
+		"\"functions_scanned\": %lu, \"functions_skipped\": %lu, "
+		"\"statements_scanned\": %lu, \"calls_examined\": %lu, \"calls_folded\": %lu, "
+		"\"skipped\": {\"non_literal\": %lu, \"argument_count\": %lu, \"unknown_function\": %lu}, "
+		"\"strcmp_chains\": %lu, \"strcmp_cases\": %lu, "
+		"\"tables_built\": %lu, \"table_lookups\": %lu, "
+		"\"calls_inlined\": %lu, \"calls_to_length\": %lu, "
+		"\"literals_dropped\": %lu, \"calls_profiled\": %lu, \"usec\": %ld}\n",
+		stats.functions_scanned, stats.functions_skipped,
+		stats.statements_scanned, stats.calls_examined, stats.calls_folded,
+		stats.skipped_non_literal, stats.skipped_argument_count, stats.skipped_unknown_function,
+		stats.strcmp_chains, stats.strcmp_cases,
+		stats.tables_built, stats.table_lookups,
+		stats.calls_inlined, stats.calls_to_length,
+		stats.literals_dropped, stats.calls_profiled, stats.usec);
+
+	append_locked(stats_path, "stats", buf, p - buf);
+	XDELETEVEC(buf);
+}
+
+
+/*****************************************************************************
+ * hash-only literals
+ *
+ * A folded call leaves its literal unreferenced, and string constants are
+ * only emitted when referenced, but static read-only arrays are not: at -O0
+ * and with -fno-toplevel-reorder the compiler keeps every static variable.
+ * Arrays whose string was folded are collected, and once the IPA passes
+ * are done those without any reference left lose that pin, so the removal
+ * of unreachable symbols before expansion drops them. Arrays folded only
+ * after IPA, by the SSA pass following inlining, are left in place.
+ *
+ * With literals=section the manifest lines of the folds are written to
+ * the non-loaded STRHASH_LITERALS_SECTION of the object, which the linker
+ * concatenates into the manifest of the whole program.
+ ****************************************************************************/
+
+#define STRHASH_LITERALS_SECTION ".strhash_manifest"
+
+static vec<tree, va_gc> * literal_decls = NULL;
+
+static const struct ggc_root_tab literal_decls_ggc_roots[] = {
+	{ &literal_decls, 1, sizeof(literal_decls),
+		&gt_ggc_mx_vec_tree_va_gc_, &gt_pch_nx_vec_tree_va_gc_ },
+	LAST_GGC_ROOT_TAB
+};
+
+/* the array a string argument points into, or the read-only pointer
+ * holding it, through SSA copies and constant offsets, or NULL_TREE for a
+ * plain literal. */
+static tree literal_decl(tree expr) {
+	for (int depth = 0; depth < 8; ++depth) {
+		STRIP_NOPS(expr);
+		if (VAR_P(expr)) {
+			return expr;
+		}
+		if (ADDR_EXPR == TREE_CODE(expr)) {
+			tree base = get_base_address(TREE_OPERAND(expr, 0));
+			return (base && VAR_P(base)) ? base : NULL_TREE;
+		}
+		if (SSA_NAME != TREE_CODE(expr)) break;
+
+		gimple * def = SSA_NAME_DEF_STMT(expr);
+		if (!is_gimple_assign(def)) break;
+
+		enum tree_code code = gimple_assign_rhs_code(def);
+		if (gimple_assign_single_p(def) || CONVERT_EXPR_CODE_P(code) || POINTER_PLUS_EXPR == code) {
+			expr = gimple_assign_rhs1(def);
+		}
+		else {
+			break;
+		}
+	}
+	return NULL_TREE;
+}
+
+static void track_literal_decl(tree arg) {
+	if (LITERALS_KEEP == literals_mode) {
+		return;
+	}
+	tree decl = literal_decl(arg);
+	if (decl && TREE_STATIC(decl) && TREE_READONLY(decl) && !TREE_PUBLIC(decl) && !DECL_PRESERVE_P(decl)) {
+		vec_safe_push(literal_decls, decl);
+	}
+}
+
+static void drop_literal_decls(void * gcc_data, void * user_data) {
+#if BUILDING_GCC_VERSION >= 5000
+	tree decl;
+	unsigned int i;
+	FOR_EACH_VEC_SAFE_ELT(literal_decls, i, decl) {
+		varpool_node * node = varpool_node::get(decl);
+		if (!node || !node->definition || !node->force_output || TREE_THIS_VOLATILE(decl) || node->referred_to_p()) {
+			continue;
+		}
+		node->force_output = false;
+		++stats.literals_dropped;
+	}
+#endif
+	vec_free(literal_decls);
+}
+
+/* PLUGIN_FINISH_UNIT comes before the end of the assembly file. */
+static void emit_literals_section(void * gcc_data, void * user_data) {
+	if (!manifest_len || !asm_out_file) {
+		return;
+	}
+	switch_to_section(get_section(STRHASH_LITERALS_SECTION, SECTION_DEBUG, NULL));
+	assemble_string(manifest_buf, manifest_len);
+}
+
+
+/*****************************************************************************
+ * minimal perfect hash tables
+ *
+ * A static array of string literals declared with the strhash_table(fn)
+ * attribute gets a CHD table over fn hashes of its keys, built when the
+ * front end finishes the declaration and emitted as a read-only uint32_t
+ * array next to it, see strhash-mph.h for its layout. Lookups of the array
+ * with strhash_table_index() are then rewritten to strhash_mph_find().
+ ****************************************************************************/
+
+/* tables never place more keys than the runtime int can index */
+#define MPH_MAX_KEYS 0x7fffffffU
+/* displacements tried per bucket before giving up */
+#define MPH_MAX_DISP (1U << 24)
+
+/* keys array -> TREE_LIST of the hash function decl and the table */
+static hash_map<tree, tree> * strhash_tables = NULL;
+
+/* the same trees and strhash_mph_find() kept for the garbage collector */
+static vec<tree, va_gc> * strhash_table_roots = NULL;
+
+static const struct ggc_root_tab strhash_table_ggc_roots[] = {
+	{ &strhash_table_roots, 1, sizeof(strhash_table_roots),
+		&gt_ggc_mx_vec_tree_va_gc_, &gt_pch_nx_vec_tree_va_gc_ },
+	LAST_GGC_ROOT_TAB
+};
+
+struct mph_key {
+	uint32_t hash;
+	uint32_t pos;
+};
+
+static int mph_key_cmp(const void * a, const void * b) {
+	const struct mph_key * x = (const struct mph_key *)a;
+	const struct mph_key * y = (const struct mph_key *)b;
+	if (x->hash != y->hash) return x->hash < y->hash ? -1 : 1;
+	return x->pos < y->pos ? -1 : (x->pos > y->pos);
+}
+
+/* fills mph with the table of n keys of distinct hashes, returns false
+ * when some bucket fits under no displacement. */
+static bool mph_build(const struct mph_key * keys, uint32_t n, uint32_t nbuckets, uint32_t * mph) {
+	uint32_t * start = XCNEWVEC(uint32_t, nbuckets + 1);
+	uint32_t * fill = XNEWVEC(uint32_t, nbuckets);
+	uint32_t * order = XNEWVEC(uint32_t, n);
+	uint32_t * slots = XNEWVEC(uint32_t, n);
+	unsigned char * taken = XCNEWVEC(unsigned char, n);
+	uint32_t * disp = mph + 2;
+	uint32_t * index = mph + 2 + nbuckets;
+	uint32_t i, b, maxsize = 0;
+	bool ok = true;
+
+	mph[0] = n;
+	mph[1] = nbuckets;
+
+	/* keys grouped by bucket */
+	for (i = 0; i < n; ++i) {
+		++start[strhash_mph_bucket(keys[i].hash, nbuckets) + 1];
+	}
+	for (b = 0; b < nbuckets; ++b) {
+		maxsize = MAX(maxsize, start[b + 1]);
+		start[b + 1] += start[b];
+		fill[b] = start[b];
+		disp[b] = 0;
+	}
+	for (i = 0; i < n; ++i) {
+		order[fill[strhash_mph_bucket(keys[i].hash, nbuckets)]++] = i;
+	}
+
+	/* the largest buckets are placed first, while most slots are free */
+	for (uint32_t size = maxsize; size > 0 && ok; --size) {
+		for (b = 0; b < nbuckets && ok; ++b) {
+			if (start[b + 1] - start[b] != size) continue;
+
+			uint32_t d;
+			for (d = 0; d < MPH_MAX_DISP; ++d) {
+				uint32_t k;
+				for (k = 0; k < size; ++k) {
+					slots[k] = strhash_mph_slot(keys[order[start[b] + k]].hash, d, n);
+					if (taken[slots[k]]) break;
+					taken[slots[k]] = 1;
+				}
+				if (k == size) break;
+				while (k-- > 0) {
+					taken[slots[k]] = 0;
+				}
+			}
+
+			if (d == MPH_MAX_DISP) {
+				ok = false;
+				break;
+			}
+			disp[b] = d;
+			for (uint32_t k = 0; k < size; ++k) {
+				index[slots[k]] = keys[order[start[b] + k]].pos;
+			}
+		}
+	}
+
+	XDELETEVEC(start);
+	XDELETEVEC(fill);
+	XDELETEVEC(order);
+	XDELETEVEC(slots);
+	XDELETEVEC(taken);
+	return ok;
+}
+
+/* the number of elements of a complete array declaration or 0. */
+static unsigned HOST_WIDE_INT table_nelts(tree decl) {
+	tree type = TREE_TYPE(decl);
+	tree domain = ARRAY_TYPE == TREE_CODE(type) ? TYPE_DOMAIN(type) : NULL_TREE;
+	if (!domain || !TYPE_MAX_VALUE(domain) || !tree_fits_uhwi_p(TYPE_MAX_VALUE(domain))) {
+		return 0;
+	}
+	return tree_to_uhwi(TYPE_MAX_VALUE(domain)) + 1;
+}
+
+/* the STRING_CST an initializer element points to, or NULL_TREE. */
+static tree table_literal(tree value) {
+	STRIP_NOPS(value);
+	if (ADDR_EXPR != TREE_CODE(value)) {
+		return NULL_TREE;
+	}
+	value = TREE_OPERAND(value, 0);
+	if (ARRAY_REF == TREE_CODE(value) && integer_zerop(TREE_OPERAND(value, 1))) {
+		value = TREE_OPERAND(value, 0);
+	}
+	return STRING_CST == TREE_CODE(value) ? value : NULL_TREE;
+}
+
+/* fills strs[nelts] with the literals of the array initializer, NULL for
+ * null pointers, returns false for anything else. */
+static bool table_keys(tree decl, unsigned HOST_WIDE_INT nelts, const char ** strs) {
+	tree init = DECL_INITIAL(decl);
+	if (!init || CONSTRUCTOR != TREE_CODE(init)) {
+		return false;
+	}
+
+	unsigned HOST_WIDE_INT ix, pos = 0;
+	tree index, value;
+	FOR_EACH_CONSTRUCTOR_ELT(CONSTRUCTOR_ELTS(init), ix, index, value) {
+		if (index) {
+			if (!tree_fits_uhwi_p(index)) return false;
+			pos = tree_to_uhwi(index);
+		}
+		if (pos >= nelts) return false;
+
+		tree str = table_literal(value);
+		if (str) {
+			/* the runtime compares with strcmp, the key ends at its NUL */
+			strs[pos] = TREE_STRING_POINTER(str);
+		}
+		else {
+			STRIP_NOPS(value);
+			if (!integer_zerop(value)) return false;
+		}
+		++pos;
+	}
+	return true;
+}
+
+/* the function decl of the attribute argument or NULL_TREE. */
+static tree table_attribute_fn(tree args) {
+	tree fn = args ? TREE_VALUE(args) : NULL_TREE;
+	if (fn && ADDR_EXPR == TREE_CODE(fn)) {
+		fn = TREE_OPERAND(fn, 0);
+	}
+	return (fn && FUNCTION_DECL == TREE_CODE(fn)) ? fn : NULL_TREE;
+}
+
+static tree handle_strhash_table_attribute(tree * node, tree name, tree args, int, bool * no_add_attrs) {
+	tree decl = *node;
+	tree fn = table_attribute_fn(args);
+	const struct hashfn_desc * desc = fn ? lookup_hashfn_decl(fn) : NULL;
+
+	if (!VAR_P(decl) || ARRAY_TYPE != TREE_CODE(TREE_TYPE(decl)) || !POINTER_TYPE_P(TREE_TYPE(TREE_TYPE(decl)))) {
+		warning(OPT_Wattributes, "%qE attribute only applies to arrays of string pointers", name);
+		*no_add_attrs = true;
+	}
+	else
+	if (!desc || HASHFN_CSTR != desc->kind || noop_hash == desc->fn.cstr) {
+		warning(OPT_Wattributes, "%qE attribute argument is not a known %<unsigned int (const char *)%> hash function", name);
+		*no_add_attrs = true;
+	}
+	return NULL_TREE;
+}
+
+static struct attribute_spec strhash_table_attribute = {
+	.name = "strhash_table",
+	.min_length = 1,
+	.max_length = 1,
+	.decl_required = true,
+	.type_required = false,
+	.function_type_required = false,
+#if BUILDING_GCC_VERSION >= 8000
+	.affects_type_identity = false,
+	.handler = handle_strhash_table_attribute,
+	.exclude = NULL,
+#else
+	.handler = handle_strhash_table_attribute,
+	.affects_type_identity = false,
+#endif
+};
+
+static void strhash_register_attributes(void * gcc_data, void * user_data) {
+	register_attribute(&strhash_attribute);
+	register_attribute(&strhash_table_attribute);
+}
+
+static void build_strhash_table(tree decl, tree fn) {
+	const location_t loc = DECL_SOURCE_LOCATION(decl);
+	const struct hashfn_desc * desc = lookup_hashfn_decl(fn);
+	const unsigned HOST_WIDE_INT nelts = table_nelts(decl);
+
+	if (!TREE_STATIC(decl) || !TYPE_READONLY(TREE_TYPE(TREE_TYPE(decl))) || !nelts || nelts > MPH_MAX_KEYS) {
+		error_at(loc, "%<strhash_table%> attribute requires a static non-empty array of %<const char * const%>");
+		return;
+	}
+
+	const char ** strs = XCNEWVEC(const char *, nelts);
+	struct mph_key * keys = XNEWVEC(struct mph_key, nelts);
+	uint32_t n = 0;
+	if (!table_keys(decl, nelts, strs)) {
+		error_at(loc, "%<strhash_table%> attribute requires string literal or null initializers of %qD", decl);
+		XDELETEVEC(strs);
+		XDELETEVEC(keys);
+		return;
+	}
+	for (uint32_t i = 0; i < nelts; ++i) {
+		if (strs[i]) {
+			keys[n].hash = desc->fn.cstr(strs[i]);
+			keys[n].pos = i;
+			++n;
+		}
+	}
+
+	/* repeated keys are found at their first position, like the runtime
+	 * scan does; different keys of the same hash can not be placed. */
+	qsort(keys, n, sizeof(keys[0]), mph_key_cmp);
+	uint32_t unique = 0;
+	for (uint32_t i = 0; i < n; ++i) {
+		if (unique && keys[unique - 1].hash == keys[i].hash) {
+			const char * a = strs[keys[unique - 1].pos];
+			const char * b = strs[keys[i].pos];
+			if (strcmp(a, b) == 0) continue;
+			error_at(loc, "keys %qs and %qs of %qD have the same %qs value", a, b, decl, desc->name);
+			XDELETEVEC(strs);
+			XDELETEVEC(keys);
+			return;
+		}
+		keys[unique++] = keys[i];
+	}
+	n = unique;
+
+	const uint32_t nbuckets = (n + 3) / 4;
+	const uint32_t size = 2 + nbuckets + n;
+	uint32_t * mph = XNEWVEC(uint32_t, size);
+	bool built = mph_build(keys, n, nbuckets, mph);
+	XDELETEVEC(strs);
+	XDELETEVEC(keys);
+	if (!built) {
+		error_at(loc, "no perfect hash table of %qD found", decl);
+		XDELETEVEC(mph);
+		return;
+	}
+
+	/* the table as a static read-only array next to the keys */
+	static unsigned int counter = 0;
+	char name[256];
+	snprintf(name, sizeof(name), "%.200s.strhash_mph.%u", IDENTIFIER_POINTER(DECL_NAME(decl)), counter++);
+
+	tree type = build_array_type_nelts(build_qualified_type(uint32_type_node, TYPE_QUAL_CONST), size);
+	vec<constructor_elt, va_gc> * elts = NULL;
+	vec_alloc(elts, size);
+	for (uint32_t i = 0; i < size; ++i) {
+		CONSTRUCTOR_APPEND_ELT(elts, size_int(i), build_int_cstu(uint32_type_node, mph[i]));
+	}
+	XDELETEVEC(mph);
+
+	tree ctor = build_constructor(type, elts);
+	TREE_CONSTANT(ctor) = 1;
+	TREE_STATIC(ctor) = 1;
+
+	tree var = build_decl(loc, VAR_DECL, get_identifier(name), type);
+	SET_DECL_ASSEMBLER_NAME(var, DECL_NAME(var));
+	TREE_STATIC(var) = 1;
+	TREE_READONLY(var) = 1;
+	TREE_PUBLIC(var) = 0;
+	DECL_ARTIFICIAL(var) = 1;
+	DECL_IGNORED_P(var) = 1;
+	DECL_INITIAL(var) = ctor;
+	rest_of_decl_compilation(var, 1, 0);
+
+	if (!strhash_tables) {
+		strhash_tables = new hash_map<tree, tree>;
+	}
+	tree table = tree_cons(fn, var, NULL_TREE);
+	strhash_tables->put(decl, table);
+	vec_safe_push(strhash_table_roots, decl);
+	vec_safe_push(strhash_table_roots, table);
+	++stats.tables_built;
+}
+
+static void strhash_table_finish_decl(void * gcc_data, void * user_data) {
+	tree decl = (tree)gcc_data;
+	if (!VAR_P(decl)) {
+		return;
+	}
+	tree attr = lookup_attribute("strhash_table", DECL_ATTRIBUTES(decl));
+	tree fn = attr ? table_attribute_fn(TREE_VALUE(attr)) : NULL_TREE;
+	if (fn) {
+		build_strhash_table(decl, fn);
+	}
+}
+
+/* the table of the keys array a strhash_table_index() argument points to. */
+static tree lookup_strhash_table(tree arg, tree * keys) {
+	STRIP_NOPS(arg);
+	if (ADDR_EXPR == TREE_CODE(arg)) {
+		arg = TREE_OPERAND(arg, 0);
+		if (ARRAY_REF == TREE_CODE(arg) && integer_zerop(TREE_OPERAND(arg, 1))) {
+			arg = TREE_OPERAND(arg, 0);
+		}
+	}
+	if (!VAR_P(arg) || !strhash_tables) {
+		return NULL_TREE;
+	}
+	tree * table = strhash_tables->get(arg);
+	*keys = arg;
+	return table ? *table : NULL_TREE;
+}
+
+/* int strhash_mph_find(const uint32_t *, unsigned int (*)(const char *),
+ *     const char * const *, const char *) */
+static tree strhash_mph_find_decl(void) {
+	static tree decl = NULL_TREE;
+	if (!decl) {
+		tree cchar_ptr = build_pointer_type(build_qualified_type(char_type_node, TYPE_QUAL_CONST));
+		tree hash_ptr = build_pointer_type(build_function_type_list(unsigned_type_node, cchar_ptr, NULL_TREE));
+		tree type = build_function_type_list(integer_type_node,
+			build_pointer_type(build_qualified_type(uint32_type_node, TYPE_QUAL_CONST)),
+			hash_ptr,
+			build_pointer_type(build_qualified_type(cchar_ptr, TYPE_QUAL_CONST)),
+			cchar_ptr,
+			NULL_TREE);
+		decl = build_fn_decl("strhash_mph_find", type);
+		SET_DECL_ASSEMBLER_NAME(decl, get_identifier("strhash_mph_find"));
+		DECL_PURE_P(decl) = 1;
+		vec_safe_push(strhash_table_roots, decl);
+	}
+	return decl;
+}
+
+
+/*****************************************************************************
+ * front end builtins
+ *
+ * Every hash taking a string is also declared as __builtin_strhash_<fn>, a
+ * machine specific builtin folded by a hook chained in front of the target
+ * one. The C front end folds calls to __builtin_ functions as it builds
+ * them and C++ does so in constant expressions, so calls with literal
+ * arguments become integer constants usable in case labels, static
+ * initializers, array bounds and static assertions, see STRHASH_CONST()
+ * in hashfns.h. The remaining calls are redirected to the library function
+ * before the CFG is built, the target never expands them.
+ ****************************************************************************/
+
+/* GCC 10 passes machine specific builtins to the check_builtin_call hook,
+ * which decodes a class from the low bits of their code, zero being the
+ * generic one. Earlier releases keep only 11 bits of the code. */
+#if BUILDING_GCC_VERSION >= 10000
+#define STRHASH_BUILTIN_CODE(i) (0x7f000000 + ((i) << 4))
+#else
+#define STRHASH_BUILTIN_CODE(i) (0x780 + (i))
+#endif
+
+static tree (* target_fold_builtin)(tree, int, tree *, bool) = NULL;
+
+static const struct hashfn_desc * hashfn_builtin_desc(tree fndecl) {
+	if (BUILT_IN_MD != DECL_BUILT_IN_CLASS(fndecl)) {
+		return NULL;
+	}
+	return lookup_hashfn_decl(fndecl);
+}
+
+/* returns the string constant expr points into and the offset of the
+ * pointed byte, or NULL_TREE. */
+static tree string_cst_expr(tree expr, unsigned HOST_WIDE_INT * offset) {
+	tree off = NULL_TREE;
+#if BUILDING_GCC_VERSION >= 9000
+	tree mem_size = NULL_TREE, decl = NULL_TREE;
+	tree cst = string_constant(expr, &off, &mem_size, &decl);
+#else
+	tree cst = string_constant(expr, &off);
+#endif
+	if (!cst || STRING_CST != TREE_CODE(cst) || !off || !tree_fits_uhwi_p(off) ||
+		tree_to_uhwi(off) > (unsigned HOST_WIDE_INT)TREE_STRING_LENGTH(cst)) {
+		return NULL_TREE;
+	}
+	*offset = tree_to_uhwi(off);
+	return cst;
+}
+
+static tree strhash_fold_builtin(tree fndecl, int nargs, tree * args, bool ignore) {
+	const struct hashfn_desc * desc = hashfn_builtin_desc(fndecl);
+	if (!desc) {
+		return target_fold_builtin(fndecl, nargs, args, ignore);
+	}
+	if ((int)hashfn_nargs(desc) != nargs) {
+		return NULL_TREE;
+	}
+
+	unsigned HOST_WIDE_INT offset = 0;
+	tree cst = string_cst_expr(args[0], &offset);
+	if (!cst) {
+		return NULL_TREE;
+	}
+	const char * str = TREE_STRING_POINTER(cst) + offset;
+	size_t avail = TREE_STRING_LENGTH(cst) - offset;
+	size_t len = strnlen(str, avail);
+
+	/* the same limits as fold_hashfn_call() */
+	uint32_t word = 0;
+	if (hashfn_takes_length(desc)) {
+		if (!tree_fits_uhwi_p(args[1]) || tree_to_uhwi(args[1]) > avail) {
+			return NULL_TREE;
+		}
+		len = tree_to_uhwi(args[1]);
+	}
+	else
+	if (len == avail) {
+		return NULL_TREE;
+	}
+	if (HASHFN_CSTR_SEEDED == desc->kind) {
+		if (!tree_fits_uhwi_p(args[1]) || tree_to_uhwi(args[1]) > 0xffffffffU) {
+			return NULL_TREE;
+		}
+		word = (uint32_t)tree_to_uhwi(args[1]);
+	}
+
+	/* folding may be repeated, so only the manifest hears of it. */
+	unsigned HOST_WIDE_INT hval = eval_hashfn(desc, str, len, word);
+	manifest_record(desc, hval, str, len, input_location);
+	return build_int_cstu(TREE_TYPE(TREE_TYPE(fndecl)), hval);
+}
+
+/* redirects an unfolded call of a builtin to the library function. */
+static void redirect_hashfn_builtin(gimple * stmt) {
+	tree fndecl = gimple_call_fndecl(stmt);
+	const struct hashfn_desc * desc = fndecl ? hashfn_builtin_desc(fndecl) : NULL;
+	if (desc) {
+		gimple_call_set_fndecl(as_a <gcall *> (stmt), hashfn_library_decl(desc, TREE_TYPE(fndecl)));
+	}
+}
+
+/* PLUGIN_PRAGMAS comes once the front end has declared its own builtins
+ * and before preprocessing, so __has_builtin() sees these even with -E. */
+static void strhash_register_builtins(void * gcc_data, void * user_data) {
+	if (target_fold_builtin) {
+		return;
+	}
+	target_fold_builtin = targetm.fold_builtin;
+	targetm.fold_builtin = strhash_fold_builtin;
+
+	for (unsigned int i = 0; i < GCC_COUNTOF(hashfn_table); ++i) {
+		const struct hashfn_desc * desc = &hashfn_table[i];
+		tree type = hashfn_type(desc);
+		if (!type || noop_hash == desc->fn.cstr) continue;
+
+		char name[128];
+		snprintf(name, sizeof(name), "__builtin_strhash_%s", desc->name);
+		tree decl = add_builtin_function(name, type, STRHASH_BUILTIN_CODE(i), BUILT_IN_MD, NULL, NULL_TREE);
+		DECL_PURE_P(decl) = 1;
+		TREE_NOTHROW(decl) = 1;
+		add_hashfn_decl(decl, desc);
+	}
+}
+
+
+/*****************************************************************************
+ * optimization reports
+ *
+ * Folded and missed hash calls are reported to -fopt-info and to the pass
+ * dumps under OPTGROUP_OTHER, prefixed with "strhash: " since plugins can
+ * not add a group of their own.
+ ****************************************************************************/
+
+#if BUILDING_GCC_VERSION >= 9000
+#	define DUMP_LOC(stmt) (stmt)
+#else
+#	define DUMP_LOC(stmt) gimple_location(stmt)
+#endif
+
+static void ATTRIBUTE_PRINTF_3 report(bool missed, gimple * stmt, const char * fmt, ...) {
+	if (!dump_enabled_p()) {
+		return;
+	}
+	/* misses before SSA form are retried after it when optimizing. */
+	if (missed && optimize && !gimple_in_ssa_p(cfun)) {
+		return;
+	}
+
+	char buf[512];
+	va_list ap;
+	va_start(ap, fmt);
+	vsnprintf(buf, sizeof(buf), fmt, ap);
+	va_end(ap);
+	dump_printf_loc(missed ? MSG_MISSED_OPTIMIZATION : MSG_OPTIMIZED_LOCATIONS, DUMP_LOC(stmt), "strhash: %s\n", buf);
+}
+
+static void report_missed(gimple * stmt, const char * fname, const char * why) {
+	report(true, stmt, "%s call not folded: %s", fname, why);
+}
+
+/* the function before a pass in -fdump-tree-strhash_*-details */
+static void dump_before(function * fn) {
+	if (dump_file && (dump_flags & TDF_DETAILS)) {
+		fprintf(dump_file, ";; before strhash\n");
+		dump_function_to_file(fn->decl, dump_file, dump_flags);
+		fprintf(dump_file, ";; after strhash\n");
+	}
+}
+
+
+/*****************************************************************************
+ * gimple hashing calls replacement pass
+ ****************************************************************************/
+
+/* follows SSA copies, conversions and constant pointer offsets back to the
+ * expression defining expr, and read-only variables to their initializer. */
+static tree resolve_value(tree expr) {
+	for (int depth = 0; depth < 8; ++depth) {
+		STRIP_NOPS(expr);
+		if (VAR_P(expr)) {
+			tree init = ctor_for_folding(expr);
+			if (!init || error_mark_node == init || CONSTRUCTOR == TREE_CODE(init)) break;
+			expr = init;
+			continue;
+		}
+		if (SSA_NAME != TREE_CODE(expr)) break;
+
+		gimple * def = SSA_NAME_DEF_STMT(expr);
+		if (!is_gimple_assign(def)) break;
+
+		enum tree_code code = gimple_assign_rhs_code(def);
+		if (gimple_assign_single_p(def) || CONVERT_EXPR_CODE_P(code)) {
+			expr = gimple_assign_rhs1(def);
+		}
+		else
+		if (POINTER_PLUS_EXPR == code && INTEGER_CST == TREE_CODE(gimple_assign_rhs2(def))) {
+			tree base = resolve_value(gimple_assign_rhs1(def));
+			return fold_build_pointer_plus(base, gimple_assign_rhs2(def));
+		}
+		else {
+			break;
+		}
+	}
+	return expr;
+}
+
+/* string_cst_expr() of the resolved argument i. */
+static tree string_cst_arg(gimple * stmt, int i, unsigned HOST_WIDE_INT * offset) {
+	return string_cst_expr(resolve_value(gimple_call_arg(stmt, i)), offset);
+}
+
+/* builds lhs = x where the constant has the callee's return type. */
+static struct gimple * build_const_assign(gcall * call, unsigned HOST_WIDE_INT x) {
+	tree lhs = gimple_call_lhs(call);
+	if (!lhs) {
+		/* nobody uses the result, so the call just disappears. */
+		return gimple_build_nop();
+	}
+	tree rhs = build_int_cstu(gimple_call_return_type(call), x);
+	gassign * assign = gimple_build_assign(lhs, fold_convert(TREE_TYPE(lhs), rhs));
+	return (assign);
+}
+
+/* the integer argument i truncated to uint32_t like the runtime one. */
+static bool const_u32_arg(gimple_stmt_iterator * gsi, unsigned int i, uint32_t * value) {
+	tree arg = resolve_value(gimple_call_arg(gsi_stmt(*gsi), i));
+
+	/* before SSA, the value of a nested call like update(init(), ...) is
+	 * kept in a temporary assigned by the previous statement. */
+	if (VAR_P(arg) && DECL_ARTIFICIAL(arg) && !gimple_in_ssa_p(cfun)) {
+		gimple_stmt_iterator prev = *gsi;
+		gsi_prev(&prev);
+		if (!gsi_end_p(prev) && gimple_assign_single_p(gsi_stmt(prev)) && arg == gimple_assign_lhs(gsi_stmt(prev))) {
+			arg = gimple_assign_rhs1(gsi_stmt(prev));
+		}
+	}
+
+	if (INTEGER_CST != TREE_CODE(arg)) {
+		return false;
+	}
+	*value = (uint32_t)TREE_INT_CST_LOW(arg);
+	return true;
+}
+
+/* replaces the call at gsi with the constant. */
+static void replace_hashfn_call(gimple_stmt_iterator * gsi, unsigned HOST_WIDE_INT hval) {
+	gimple * stmt = gsi_stmt(*gsi);
+	gimple * newstmt = build_const_assign(as_a <gcall *> (stmt), hval);
+
+	/* the constant does not touch memory, drop the call's virtual def. */
+	tree vdef = gimple_vdef(stmt);
+	if (vdef && SSA_NAME == TREE_CODE(vdef)) {
+		unlink_stmt_vdef(stmt);
+		release_ssa_name(vdef);
+	}
+	gsi_replace(gsi, newstmt, true);
+	++stats.calls_folded;
+}
+
+/* strhash_table_index(keys, n, s) over a whole array with a table: a
+ * literal s is looked up now, others by strhash_mph_find() before SSA. */
+static bool fold_table_index(gimple_stmt_iterator * gsi) {
+	gimple * stmt = gsi_stmt(*gsi);
+	tree keys = NULL_TREE;
+	tree table = lookup_strhash_table(resolve_value(gimple_call_arg(stmt, 0)), &keys);
+	tree n = resolve_value(gimple_call_arg(stmt, 1));
+	if (!table || !tree_fits_uhwi_p(n) || tree_to_uhwi(n) != table_nelts(keys)) {
+		report_missed(stmt, "strhash_table_index", "not a strhash_table array with its length");
+		++stats.skipped_non_literal;
+		return false;
+	}
+
+	unsigned HOST_WIDE_INT offset = 0;
+	tree cst = string_cst_arg(stmt, 2, &offset);
+	if (cst && strnlen(TREE_STRING_POINTER(cst) + offset, TREE_STRING_LENGTH(cst) - offset) < TREE_STRING_LENGTH(cst) - offset) {
+		const unsigned HOST_WIDE_INT nelts = table_nelts(keys);
+		const char ** strs = XCNEWVEC(const char *, nelts);
+		HOST_WIDE_INT pos = -1;
+		table_keys(keys, nelts, strs);
+		for (unsigned HOST_WIDE_INT i = 0; i < nelts && pos < 0; ++i) {
+			if (strs[i] && strcmp(strs[i], TREE_STRING_POINTER(cst) + offset) == 0) {
+				pos = i;
+			}
+		}
+		XDELETEVEC(strs);
+		report(false, stmt, "strhash_table_index of \"%s\" folded to " HOST_WIDE_INT_PRINT_DEC,
+			TREE_STRING_POINTER(cst) + offset, pos);
+		replace_hashfn_call(gsi, (unsigned HOST_WIDE_INT)pos);
+		return true;
+	}
+
+	/* the rewritten call would need new virtual operands in SSA form. */
+	if (gimple_in_ssa_p(cfun)) {
+		return false;
+	}
+
+	gcall * call = gimple_build_call(strhash_mph_find_decl(), 4,
+		build_fold_addr_expr(TREE_VALUE(table)), build_fold_addr_expr(TREE_PURPOSE(table)),
+		gimple_call_arg(stmt, 0), gimple_call_arg(stmt, 2));
+	gimple_call_set_lhs(call, gimple_call_lhs(stmt));
+	gimple_set_location(call, gimple_location(stmt));
+	report(false, stmt, "strhash_table_index rewritten to a perfect hash lookup");
+	gsi_replace(gsi, call, true);
+	++stats.table_lookups;
+	return true;
+}
+
+/* replaces the hash function call at gsi with its value if all arguments
+ * are known, returns true if the call is replaced. */
+static bool fold_hashfn_call(gimple_stmt_iterator * gsi) {
+	gimple * stmt = gsi_stmt(*gsi);
+	location_t locus = gimple_location(stmt);
+	++stats.calls_examined;
+
+	/* lookup implementation of the called function. */
+	tree fndecl = gimple_call_fndecl(stmt);
+	const struct hashfn_desc * desc = fndecl ? lookup_hashfn_decl(fndecl) : NULL;
+	if (!desc) {
+		++stats.skipped_unknown_function;
+		return false;
+	}
+	const char * fname = desc->name;
+
+	/* check the function has expected number of arguments. */
+	if (hashfn_nargs(desc) != gimple_call_num_args(stmt)) {
+		if (enable_mismatch_args_warning) {
+			warning_at(locus, 0, "Hash function %qs called with unexpected number of arguments.", fname);
+			inform(locus, "Folding to integer constant will NOT be performed.");
+		}
+		report_missed(stmt, fname, "unexpected number of arguments");
+		++stats.skipped_argument_count;
+		return false;
+	}
+
+	if (HASHFN_TABLE_INDEX == desc->kind) {
+		return fold_table_index(gsi);
+	}
+
+	/* the state of update and final calls must be known as well. */
+	uint32_t word = 0;
+	if ((HASHFN_UPDATE == desc->kind || HASHFN_FINAL == desc->kind) && !const_u32_arg(gsi, 0, &word)) {
+		if (enable_non_literal_arg_warning) {
+			warning_at(locus, 0, "Hash function %qs called with non constant state.", fname);
+			inform(locus, "Folding to integer constant will NOT be performed.");
+		}
+		report_missed(stmt, fname, "non constant state");
+		++stats.skipped_non_literal;
+		return false;
+	}
+
+	/* calls without a string: strhash_seed(), init and final. */
+	if (!hashfn_takes_string(desc)) {
+		/* strhash_seed() is only known when the seed is given to the plugin. */
+		if (HASHFN_SEED == desc->kind && !seed_given) {
+			report_missed(stmt, fname, "no seed= option");
+			++stats.skipped_non_literal;
+			return false;
+		}
+		unsigned HOST_WIDE_INT hval = eval_hashfn(desc, NULL, 0, word);
+		if (enable_call_replacement_warning) {
+			warning_at(locus, 0, "Replacing call to %qs with %<%wu%>", fname, hval);
+		}
+		report(false, stmt, "%s call folded to " HOST_WIDE_INT_PRINT_UNSIGNED, fname, hval);
+		replace_hashfn_call(gsi, hval);
+		return true;
+	}
+
+	/* retrive argument expression. */
+	const unsigned int sarg = hashfn_string_arg(desc);
+	unsigned HOST_WIDE_INT offset = 0;
+	tree cst = string_cst_arg(stmt, sarg, &offset);
+	if (!cst) {
+		if (enable_non_literal_arg_warning) {
+			warning_at(locus, 0, "Hash function %qs called with non literal string argument.", fname);
+			inform(locus, "Folding to integer constant will NOT be performed.");
+		}
+		report_missed(stmt, fname, "non literal string argument");
+		++stats.skipped_non_literal;
+		return false;
+	}
+	const char * str = TREE_STRING_POINTER(cst) + offset;
+	size_t avail = TREE_STRING_LENGTH(cst) - offset;
+	size_t len = strnlen(str, avail);
+
+	/* length-aware variants may hash up to the whole literal including
+	 * its terminating and embedded NULs, but never past it. */
+	if (hashfn_takes_length(desc)) {
+		tree lenarg = resolve_value(gimple_call_arg(stmt, sarg + 1));
+		if (!tree_fits_uhwi_p(lenarg) || tree_to_uhwi(lenarg) > avail) {
+			if (enable_non_literal_arg_warning) {
+				warning_at(locus, 0, "Hash function %qs called with non constant length or length exceeding the literal.", fname);
+				inform(locus, "Folding to integer constant will NOT be performed.");
+			}
+			report_missed(stmt, fname, "non constant length or length exceeding the literal");
+			++stats.skipped_non_literal;
+			return false;
+		}
+		len = tree_to_uhwi(lenarg);
+	}
+	else
+	if (len == avail) {
+		/* the array is not terminated, the runtime would read past it. */
+		report_missed(stmt, fname, "unterminated string argument");
+		++stats.skipped_non_literal;
+		return false;
+	}
+
+	/* the seed of seeded hashes, the state was taken above. */
+	if (HASHFN_CSTR_SEEDED == desc->kind && !const_u32_arg(gsi, 1, &word)) {
+		if (enable_non_literal_arg_warning) {
+			warning_at(locus, 0, "Hash function %qs called with non constant seed.", fname);
+			inform(locus, "Folding to integer constant will NOT be performed.");
+		}
+		report_missed(stmt, fname, "non constant seed");
+		++stats.skipped_non_literal;
+		return false;
+	}
+
+	/* here we are replacing the function call with constant assignment. */
+	unsigned HOST_WIDE_INT hval = eval_hashfn(desc, str, len, word);
+	if (enable_call_replacement_warning) {
+		char buf[256];
+		escaped(buf, sizeof(buf), str, len);
+		warning_at(locus, 0, "Replacing %<%s(\"%s\")%> with %<%wu%>", fname, buf, hval);
+	}
+	if (dump_enabled_p()) {
+		char buf[256];
+		escaped(buf, sizeof(buf), str, len);
+		report(false, stmt, "%s(\"%s\") folded to " HOST_WIDE_INT_PRINT_UNSIGNED, fname, buf, hval);
+	}
+	manifest_record(desc, hval, str, len, locus);
+	track_literal_decl(gimple_call_arg(stmt, sarg));
+	replace_hashfn_call(gsi, hval);
+
+	return true;
+}
+
+static bool strhash_pass_gate(void *, function * fn) {
+	if (in_lto_p) {
+		track_symtab_hashfn_decls();
+	}
+	if (hashfn_decls_used()) {
+		return true;
+	}
+	++stats.functions_skipped;
+	return false;
+}
+
+static tree strhash_pass_fold_stmt(gimple_stmt_iterator * gsi, bool * handled_ops, struct walk_stmt_info *) {
+	++stats.statements_scanned;
+	if (is_gimple_call(gsi_stmt(*gsi))) {
+		if (!fold_hashfn_call(gsi)) {
+			redirect_hashfn_builtin(gsi_stmt(*gsi));
+		}
+		*handled_ops = true;
+	}
+	return NULL_TREE;
+}
+
+static unsigned int strhash_pass_execute(void *, function * fn) {
+	long start = stats_timer_start();
+	++stats.functions_scanned;
+	dump_before(fn);
+
+	/* the walker enters binds, try blocks and the other nested sequences. */
+	struct walk_stmt_info wi;
+	memset(&wi, 0, sizeof(wi));
+	walk_gimple_seq_mod(&fn->gimple_body, strhash_pass_fold_stmt, NULL, &wi);
+
+	stats_timer_stop(start);
+	return 0;
+}
+
+static struct pass_data strhash_pass_data = {
+	.type = GIMPLE_PASS,
+	.name = "strhash_pass",
+	.optinfo_flags = OPTGROUP_OTHER,
+	.tv_id = TV_PLUGIN_RUN,
+	.properties_required = PROP_gimple_any,
+	.properties_provided = 0,
+	.properties_destroyed = 0,
+	.todo_flags_start = 0,
+	.todo_flags_finish = 0,
+};
+
+DECLARE_GIMPLE_PASS(strhash_pass, strhash_pass_data, strhash_pass_gate, strhash_pass_execute);
+
+
+/*****************************************************************************
+ * inline expansion of short hashes
+ *
+ * With the inline=<n> option the SSA pass expands the calls it can not fold
+ * of the hashes below into straight line code, when they hash a constant
+ * length of at most n bytes or a whole array of at most n bytes. Bytes of
+ * an array past the terminating NUL or past the length are loaded as well
+ * and masked out, so no branches are added. Before that xxx_hash(s) after
+ * a strlen(s) with no store in between becomes xxx_hash_n(s, len).
+ ****************************************************************************/
+
+#define STRHASH_INLINE_DEFAULT 16
+#define STRHASH_INLINE_MAX 256
+
+/* hashes of one multiply and one add or xor per byte */
+struct hashfn_step {
+	unsigned int (* cstr)(const char *);
+	unsigned int (* mem)(const void *, size_t);
+	uint32_t init;
+	uint32_t mul;
+	enum tree_code mix;
+	bool mix_first;
+};
+
+static const struct hashfn_step hashfn_steps[] = {
+	{ djb2_hash, djb2_hash_n, 5381, 33, PLUS_EXPR, false },
+	{ sdbm_hash, sdbm_hash_n, 0, 65599, PLUS_EXPR, false },
+	{ bkdr_hash, bkdr_hash_n, 0, 131313, PLUS_EXPR, false },
+	{ fnv1_hash, fnv1_hash_n, 0x811c9dc5, 0x01000193, BIT_XOR_EXPR, false },
+	{ fnv1a_hash, fnv1a_hash_n, 0x811c9dc5, 0x01000193, BIT_XOR_EXPR, true },
+};
+
+static const struct hashfn_step * hashfn_step_of(const struct hashfn_desc * desc) {
+	for (unsigned int i = 0; i < GCC_COUNTOF(hashfn_steps); ++i) {
+		const struct hashfn_step * step = &hashfn_steps[i];
+		if ((HASHFN_CSTR == desc->kind && step->cstr == desc->fn.cstr) ||
+			(HASHFN_MEM == desc->kind && step->mem == desc->fn.mem)) {
+			return step;
+		}
+	}
+	return NULL;
+}
+
+/* xxx_hash_n of the hashfns.c hash xxx_hash, NULL if there is none. */
+static const struct hashfn_desc * hashfn_length_variant(const struct hashfn_desc * desc) {
+	if (HASHFN_CSTR != desc->kind && HASHFN_CSTR64 != desc->kind) {
+		return NULL;
+	}
+	enum hashfn_kind kind = HASHFN_CSTR == desc->kind ? HASHFN_MEM : HASHFN_MEM64;
+	size_t len = strlen(desc->name);
+	for (unsigned int i = 0; i < GCC_COUNTOF(hashfn_table); ++i) {
+		const struct hashfn_desc * d = &hashfn_table[i];
+		if (kind == d->kind && strncmp(d->name, desc->name, len) == 0 && strcmp(d->name + len, "_n") == 0) {
+			return d;
+		}
+	}
+	return NULL;
+}
 
-#include "hashfns.h"
+/* the size of the array ptr points to the start of, when that is a whole
+ * variable or a member other than a trailing one, 0 if unknown. */
+static unsigned HOST_WIDE_INT array_bound(tree ptr) {
+	if (SSA_NAME == TREE_CODE(ptr)) {
+		gimple * def = SSA_NAME_DEF_STMT(ptr);
+		if (!is_gimple_assign(def) || ADDR_EXPR != gimple_assign_rhs_code(def)) {
+			return 0;
+		}
+		ptr = gimple_assign_rhs1(def);
+	}
+	if (ADDR_EXPR != TREE_CODE(ptr)) {
+		return 0;
+	}
+
+	tree ref = TREE_OPERAND(ptr, 0);
+	if (ARRAY_REF == TREE_CODE(ref) && integer_zerop(TREE_OPERAND(ref, 1))) {
+		ref = TREE_OPERAND(ref, 0);
+	}
+	tree type = TREE_TYPE(ref);
+	if (ARRAY_TYPE != TREE_CODE(type) || !TYPE_SIZE_UNIT(type) || !tree_fits_uhwi_p(TYPE_SIZE_UNIT(type))) {
+		return 0;
+	}
+	if (!VAR_P(ref) && COMPONENT_REF != TREE_CODE(ref)) {
+		return 0;
+	}
+#if BUILDING_GCC_VERSION >= 13000
+	if (COMPONENT_REF == TREE_CODE(ref) && array_ref_flexible_size_p(ref)) {
+#else
+	if (COMPONENT_REF == TREE_CODE(ref) && array_at_struct_end_p(ref)) {
+#endif
+		return 0;
+	}
+	return tree_to_uhwi(TYPE_SIZE_UNIT(type));
+}
+
+/* the result of a strlen(s) dominating stmt with the same memory state,
+ * so that nothing may have changed the string in between. */
+static tree known_strlen(gimple * stmt, tree s) {
+	if (SSA_NAME != TREE_CODE(s) || !gimple_vuse(stmt)) {
+		return NULL_TREE;
+	}
+	calculate_dominance_info(CDI_DOMINATORS);
+
+	tree len = NULL_TREE;
+	imm_use_iterator it;
+	gimple * use;
+	FOR_EACH_IMM_USE_STMT(use, it, s) {
+		if (len || use == stmt || !gimple_call_builtin_p(use, BUILT_IN_STRLEN) ||
+			!gimple_call_lhs(use) || gimple_vuse(use) != gimple_vuse(stmt)) {
+			continue;
+		}
+		if (gimple_bb(use) != gimple_bb(stmt)) {
+			if (dominated_by_p(CDI_DOMINATORS, gimple_bb(stmt), gimple_bb(use))) {
+				len = gimple_call_lhs(use);
+			}
+			continue;
+		}
+		/* the same block, strlen must come first. */
+		for (gimple_stmt_iterator gsi = gsi_for_stmt(stmt); !gsi_end_p(gsi); gsi_prev(&gsi)) {
+			if (gsi_stmt(gsi) == use) {
+				len = gimple_call_lhs(use);
+				break;
+			}
+		}
+	}
+	return len;
+}
+
+/* replaces the call at gsi with a call of its length variant desc, returns
+ * the new call or NULL if the virtual operands do not allow it. */
+static gimple * call_length_variant(gimple_stmt_iterator * gsi, const struct hashfn_desc * desc, tree len) {
+	gimple * stmt = gsi_stmt(*gsi);
+	tree fndecl = hashfn_library_decl(desc, hashfn_type(desc));
+	bool pure = 0 != (flags_from_decl_or_type(fndecl) & (ECF_PURE | ECF_CONST));
+	tree vdef = gimple_vdef(stmt);
+	if (!vdef && !pure) {
+		return NULL;
+	}
+
+	gcall * call = gimple_build_call(fndecl, 2, gimple_call_arg(stmt, 0), len);
+	gimple_call_set_lhs(call, gimple_call_lhs(stmt));
+	gimple_set_location(call, gimple_location(stmt));
+	gimple_set_vuse(call, gimple_vuse(stmt));
+	if (vdef && pure) {
+		unlink_stmt_vdef(stmt);
+		release_ssa_name(vdef);
+	}
+	else
+	if (vdef) {
+		gimple_set_vdef(call, vdef);
+		SSA_NAME_DEF_STMT(vdef) = call;
+	}
+	report(false, stmt, "%s call rewritten to %s with the known strlen", lookup_hashfn_decl(gimple_call_fndecl(stmt))->name, desc->name);
+	gsi_replace(gsi, call, true);
+	++stats.calls_to_length;
+	return call;
+}
+
+/* replaces the call at gsi with step over n bytes at its pointer. When
+ * masked only the bytes before the NUL or before the length argument
+ * count. */
+static void expand_hashfn_call(gimple_stmt_iterator * gsi, const struct hashfn_step * step,
+	unsigned HOST_WIDE_INT n, bool masked) {
+
+	gimple * stmt = gsi_stmt(*gsi);
+	tree ptr = gimple_call_arg(stmt, 0);
+	tree len = gimple_call_num_args(stmt) > 1 ? gimple_call_arg(stmt, 1) : NULL_TREE;
+	report(false, stmt, "%s call expanded inline over " HOST_WIDE_INT_PRINT_UNSIGNED " bytes%s",
+		lookup_hashfn_decl(gimple_call_fndecl(stmt))->name, n, masked ? ", masked" : "");
+	tree uchar_ptr = build_pointer_type(unsigned_char_type_node);
+	tree mul = build_int_cst(unsigned_type_node, step->mul);
+	tree hash = build_int_cst(unsigned_type_node, step->init);
+	tree live = boolean_true_node;
+	gimple_seq seq = NULL;
+
+	for (unsigned HOST_WIDE_INT i = 0; i < n; ++i) {
+		tree ref = build2(MEM_REF, unsigned_char_type_node, unshare_expr(ptr), build_int_cst(uchar_ptr, i));
+		gassign * load = gimple_build_assign(make_ssa_name(unsigned_char_type_node), ref);
+		gimple_set_vuse(load, gimple_vuse(stmt));
+		/* masked bytes may well be uninitialized. */
+#if BUILDING_GCC_VERSION >= 12000
+		suppress_warning(load, OPT_Wuninitialized);
+#else
+		gimple_set_no_warning(load, true);
+#endif
+		gimple_seq_add_stmt(&seq, load);
+		tree c = gimple_convert(&seq, unsigned_type_node, gimple_assign_lhs(load));
+
+		tree next;
+		if (step->mix_first) {
+			next = gimple_build(&seq, MULT_EXPR, unsigned_type_node,
+				gimple_build(&seq, step->mix, unsigned_type_node, hash, c), mul);
+		}
+		else {
+			next = gimple_build(&seq, step->mix, unsigned_type_node,
+				gimple_build(&seq, MULT_EXPR, unsigned_type_node, hash, mul), c);
+		}
+
+		if (masked) {
+			if (len) {
+				live = gimple_build(&seq, LT_EXPR, boolean_type_node, build_int_cst(TREE_TYPE(len), i), len);
+			}
+			else {
+				tree nonzero = gimple_build(&seq, NE_EXPR, boolean_type_node, c, build_zero_cst(unsigned_type_node));
+				live = gimple_build(&seq, BIT_AND_EXPR, boolean_type_node, live, nonzero);
+			}
+			next = gimple_build(&seq, COND_EXPR, unsigned_type_node, live, next, hash);
+		}
+		hash = next;
+	}
+
+	for (gimple_stmt_iterator i = gsi_start(seq); !gsi_end_p(i); gsi_next(&i)) {
+		gimple_set_location(gsi_stmt(i), gimple_location(stmt));
+	}
+	gsi_insert_seq_before(gsi, seq, GSI_SAME_STMT);
+
+	tree lhs = gimple_call_lhs(stmt);
+	gimple * result = lhs ? gimple_build_assign(lhs, fold_convert(TREE_TYPE(lhs), hash)) : gimple_build_nop();
+	tree vdef = gimple_vdef(stmt);
+	if (vdef && SSA_NAME == TREE_CODE(vdef)) {
+		unlink_stmt_vdef(stmt);
+		release_ssa_name(vdef);
+	}
+	gsi_replace(gsi, result, true);
+	++stats.calls_inlined;
+}
+
+/* the inline= treatment of a call fold_hashfn_call() left, returns true
+ * if the call at gsi was replaced. */
+static bool inline_hashfn_call(gimple_stmt_iterator * gsi) {
+	gimple * stmt = gsi_stmt(*gsi);
+	tree fndecl = gimple_call_fndecl(stmt);
+	const struct hashfn_desc * desc = fndecl ? lookup_hashfn_decl(fndecl) : NULL;
+	if (!desc || hashfn_nargs(desc) != gimple_call_num_args(stmt)) {
+		return false;
+	}
+
+	bool replaced = false;
+	const struct hashfn_desc * ndesc = hashfn_length_variant(desc);
+	tree len = ndesc ? known_strlen(stmt, gimple_call_arg(stmt, 0)) : NULL_TREE;
+	if (len) {
+		gimple * call = call_length_variant(gsi, ndesc, len);
+		if (call) {
+			stmt = call;
+			desc = ndesc;
+			replaced = true;
+		}
+	}
+
+	const struct hashfn_step * step = hashfn_step_of(desc);
+	if (!step) {
+		return replaced;
+	}
+	unsigned HOST_WIDE_INT bound = array_bound(gimple_call_arg(stmt, 0));
+	if (HASHFN_MEM == desc->kind && tree_fits_uhwi_p(gimple_call_arg(stmt, 1)) &&
+		tree_to_uhwi(gimple_call_arg(stmt, 1)) <= inline_limit) {
+		expand_hashfn_call(gsi, step, tree_to_uhwi(gimple_call_arg(stmt, 1)), false);
+	}
+	else
+	if (bound && bound <= inline_limit) {
+		expand_hashfn_call(gsi, step, bound, true);
+	}
+	else {
+		return replaced;
+	}
+	return true;
+}
 
 
 /*****************************************************************************
- * plugin global state
+ * gimple hashing calls replacement pass in SSA form
+ *
+ * Runs after every constant propagation pass, so arguments copied through
+ * variables, loaded from read-only data or passed to a function pointer
+ * resolved by propagation are folded as well.
  ****************************************************************************/
 
-static const char * const version_string = "0.1";
-static const char * const help_string = "Compile-time string hashing support.";
-static const char * plugin_name = "";
-static bool enable_mismatch_args_warning = false;
-static bool enable_non_literal_arg_warning = false;
-static bool enable_call_replacement_warning = false;
+static unsigned int strhash_ssa_pass_execute(void *, function * fn) {
+	long start = stats_timer_start();
+	unsigned int todo = 0;
+	basic_block bb;
+
+	++stats.functions_scanned;
+	dump_before(fn);
+	FOR_EACH_BB_FN(bb, fn) {
+		bool folded = false;
+		gimple_stmt_iterator gsi;
+		for (gsi = gsi_start_bb(bb); !gsi_end_p(gsi); gsi_next(&gsi)) {
+			++stats.statements_scanned;
+			if (is_gimple_call(gsi_stmt(gsi))) {
+				bool replaced = fold_hashfn_call(&gsi);
+				if (!replaced && inline_limit) {
+					replaced = inline_hashfn_call(&gsi);
+				}
+				folded |= replaced;
+			}
+		}
+		/* a folded call can not throw anymore. */
+		if (folded && gimple_purge_dead_eh_edges(bb)) {
+			free_dominance_info(CDI_DOMINATORS);
+			todo |= TODO_cleanup_cfg;
+		}
+	}
+
+	stats_timer_stop(start);
+	return todo;
+}
+
+static struct pass_data strhash_ssa_pass_data = {
+	.type = GIMPLE_PASS,
+	.name = "strhash_ssa",
+	.optinfo_flags = OPTGROUP_OTHER,
+	.tv_id = TV_PLUGIN_RUN,
+	.properties_required = PROP_cfg | PROP_ssa,
+	.properties_provided = 0,
+	.properties_destroyed = 0,
+	.todo_flags_start = 0,
+	.todo_flags_finish = 0,
+};
+
+DECLARE_GIMPLE_PASS(strhash_ssa_pass, strhash_ssa_pass_data, strhash_pass_gate, strhash_ssa_pass_execute);
 
 
 /*****************************************************************************
- * known hash functions
+ * strcmp chains to hash switch pass
+ *
+ * A chain of blocks each ending with
+ *   t = strcmp(s, "literal"); if (t == 0) goto match; else goto next;
+ * over the same subject s is rewritten to
+ *   h = hash(s); switch (h) { case hash("literal"): goto block; ... }
+ * where every case still confirms its literal with the original strcmp,
+ * and every mismatch jumps straight to the block after the chain. The pass
+ * runs right after the CFG is built, before SSA form, and is enabled with
+ * the strcmp-switch option. The program must link the chosen hash.
  ****************************************************************************/
 
-static unsigned int noop_hash(const char * s) {
-	return 0xdeadbeef;
+/* shorter chains are cheaper as they are */
+#define STRCMP_SWITCH_MIN_CASES 4
+
+struct strcmp_link {
+	basic_block bb;
+	gimple * call;
+	tree subj;
+	const char * str;
+	bool match_on_true;
+};
+
+/* returns the operand strcmp compares with a terminated literal str. */
+static tree strcmp_subject(gimple * call, const char ** str) {
+	for (unsigned int i = 0; i < 2; ++i) {
+		unsigned HOST_WIDE_INT offset = 0, other = 0;
+		tree cst = string_cst_arg(call, i, &offset);
+		if (!cst) continue;
+		const char * s = TREE_STRING_POINTER(cst) + offset;
+		size_t avail = TREE_STRING_LENGTH(cst) - offset;
+		if (strnlen(s, avail) == avail || string_cst_arg(call, 1 - i, &other)) {
+			return NULL_TREE;
+		}
+		tree subj = gimple_call_arg(call, 1 - i);
+		if (SSA_NAME != TREE_CODE(subj) && !DECL_P(subj) && !is_gimple_min_invariant(subj)) {
+			return NULL_TREE;
+		}
+		*str = s;
+		return subj;
+	}
+	return NULL_TREE;
 }
 
-static unsigned int (* lookup_hashfn(const char * name))(const char *) {
-#	pragma push_macro("HASHFN_ENTRY")
-#	define HASHFN_ENTRY(fn) \
-		{ .name = GCC_STRINGIFY(fn), .hashfn = fn }
-
-	static const struct {
-		const char * name;
-		unsigned int (* hashfn)(const char *);
-	} ftab[] = {
-		HASHFN_ENTRY(noop_hash),
-		HASHFN_ENTRY(djb2_hash),
-		HASHFN_ENTRY(sdbm_hash),
-		HASHFN_ENTRY(lose_hash),
-		HASHFN_ENTRY(rs_hash),
-		HASHFN_ENTRY(js_hash),
-		HASHFN_ENTRY(pjw_hash),
-		HASHFN_ENTRY(elf_hash),
-		HASHFN_ENTRY(bkdr_hash),
-		HASHFN_ENTRY(mabkdr_hash),
-		HASHFN_ENTRY(dek_hash),
-		HASHFN_ENTRY(ap_hash),
-		HASHFN_ENTRY(ly_hash),
-		HASHFN_ENTRY(rot13_hash),
-		HASHFN_ENTRY(faq6_hash),
-		HASHFN_ENTRY(fnv1_hash),
-		HASHFN_ENTRY(fnv1a_hash)
-	};
-#pragma pop_macro("HASHFN_ENTRY")
+/* matches bb ending with a strcmp of a literal against zero. Only the
+ * first link of a chain may hold other code. */
+static bool match_strcmp_link(basic_block bb, bool first, struct strcmp_link * link) {
+	gimple_stmt_iterator gsi = gsi_last_nondebug_bb(bb);
+	if (gsi_end_p(gsi)) return false;
+	gcond * cond = dyn_cast <gcond *> (gsi_stmt(gsi));
+	if (!cond || !integer_zerop(gimple_cond_rhs(cond))) return false;
+	if (EQ_EXPR != gimple_cond_code(cond) && NE_EXPR != gimple_cond_code(cond)) return false;
 
-	for (unsigned int i = 0; i < GCC_COUNTOF(ftab); ++i) {
-		if (strcmp(name, ftab[i].name) == 0) {
-			return ftab[i].hashfn;
+	/* the result must be a temporary nobody else reads. */
+	tree tmp = gimple_cond_lhs(cond);
+	if (SSA_NAME == TREE_CODE(tmp) ? !!SSA_NAME_VAR(tmp) : !(VAR_P(tmp) && DECL_ARTIFICIAL(tmp) && DECL_IGNORED_P(tmp))) {
+		return false;
+	}
+
+	gsi_prev_nondebug(&gsi);
+	if (gsi_end_p(gsi)) return false;
+	gimple * call = gsi_stmt(gsi);
+	if (!gimple_call_builtin_p(call, BUILT_IN_STRCMP) || gimple_call_lhs(call) != tmp) return false;
+	if (!first && gsi_stmt(gsi_start_nondebug_after_labels_bb(bb)) != call) return false;
+
+	link->subj = strcmp_subject(call, &link->str);
+	if (!link->subj) return false;
+
+	link->bb = bb;
+	link->call = call;
+	link->match_on_true = EQ_EXPR == gimple_cond_code(cond);
+	return true;
+}
+
+static void strcmp_link_edges(const struct strcmp_link * link, edge * match, edge * next) {
+	edge true_edge, false_edge;
+	extract_true_false_edges_from_block(link->bb, &true_edge, &false_edge);
+	*match = link->match_on_true ? true_edge : false_edge;
+	*next = link->match_on_true ? false_edge : true_edge;
+}
+
+/* appends the chain starting at bb to links, marking its blocks visited,
+ * and returns its length. */
+static unsigned int collect_strcmp_chain(basic_block bb, bitmap visited, vec<struct strcmp_link> * links) {
+	const unsigned int start = links->length();
+	struct strcmp_link link;
+
+	if (!match_strcmp_link(bb, true, &link)) return 0;
+
+	for (;;) {
+		/* equal literals would need the same case twice. */
+		for (unsigned int i = start; i < links->length(); ++i) {
+			if (strcmp((*links)[i].str, link.str) == 0) goto done;
 		}
+		links->safe_push(link);
+		bitmap_set_bit(visited, link.bb->index);
+
+		edge match, next;
+		strcmp_link_edges(&link, &match, &next);
+		basic_block succ = next->dest;
+		if (!single_pred_p(succ) || bitmap_bit_p(visited, succ->index)) break;
+
+		tree subj = link.subj;
+		if (!match_strcmp_link(succ, false, &link) || !operand_equal_p(subj, link.subj, 0)) break;
 	}
 
-	return NULL;
+done:
+	return links->length() - start;
+}
+
+static int compare_uhwi(const void * a, const void * b) {
+	unsigned HOST_WIDE_INT x = *(const unsigned HOST_WIDE_INT *)a;
+	unsigned HOST_WIDE_INT y = *(const unsigned HOST_WIDE_INT *)b;
+	return (x > y) - (x < y);
+}
+
+static bool hashfn_separates(const struct hashfn_desc * desc, const struct strcmp_link * chain, unsigned int n) {
+	if (HASHFN_CSTR != desc->kind || noop_hash == desc->fn.cstr) {
+		return false;
+	}
+	auto_vec<unsigned HOST_WIDE_INT> values;
+	for (unsigned int i = 0; i < n; ++i) {
+		values.safe_push(eval_hashfn(desc, chain[i].str, strlen(chain[i].str), 0));
+	}
+	values.qsort(compare_uhwi);
+	for (unsigned int i = 1; i < n; ++i) {
+		if (values[i - 1] == values[i]) return false;
+	}
+	return true;
+}
+
+/* picks a hash without collisions among the literals, preferring the ones
+ * the translation unit declares itself. */
+static tree pick_switch_hashfn(const struct strcmp_link * chain, unsigned int n, const struct hashfn_desc ** desc) {
+	unsigned int i;
+	tree decl;
+	FOR_EACH_VEC_SAFE_ELT(hashfn_decl_roots, i, decl) {
+		const struct hashfn_desc * d = lookup_hashfn_decl(decl);
+		if (BUILT_IN_MD != DECL_BUILT_IN_CLASS(decl) && hashfn_separates(d, chain, n)) {
+			*desc = d;
+			return decl;
+		}
+	}
+
+	for (i = 0; i < GCC_COUNTOF(hashfn_table); ++i) {
+		const struct hashfn_desc * d = &hashfn_table[i];
+		if (!hashfn_separates(d, chain, n)) continue;
+		*desc = d;
+		return hashfn_library_decl(d, hashfn_type(d));
+	}
+
+	return NULL_TREE;
+}
+
+static bool rewrite_strcmp_chain(const struct strcmp_link * chain, unsigned int n) {
+	edge match, next;
+
+	/* a mismatch anywhere jumps to the block after the chain, which must
+	 * not be a match target already. */
+	strcmp_link_edges(&chain[n - 1], &match, &next);
+	basic_block dflt = next->dest;
+	for (unsigned int i = 0; i < n; ++i) {
+		strcmp_link_edges(&chain[i], &match, &next);
+		if (match->dest == dflt) return false;
+	}
+
+	const struct hashfn_desc * desc = NULL;
+	tree fndecl = pick_switch_hashfn(chain, n, &desc);
+	if (!fndecl) return false;
+
+	for (unsigned int i = 0; i + 1 < n; ++i) {
+		strcmp_link_edges(&chain[i], &match, &next);
+		redirect_edge_and_branch(next, dflt);
+	}
+
+	/* split the code before the first strcmp into the dispatching block. */
+	gimple * first_call = chain[0].call;
+	location_t locus = gimple_location(first_call);
+	gimple_stmt_iterator gsi = gsi_for_stmt(first_call);
+	gsi_prev(&gsi);
+	gimple * last = (gsi_end_p(gsi) || GIMPLE_LABEL == gimple_code(gsi_stmt(gsi))) ? NULL : gsi_stmt(gsi);
+	edge fallthru = split_block(chain[0].bb, last);
+	basic_block head = fallthru->src;
+	fallthru->flags &= ~EDGE_FALLTHRU;
+
+	auto_vec<tree> labels;
+	for (unsigned int i = 0; i < n; ++i) {
+		basic_block bb = (0 == i) ? fallthru->dest : chain[i].bb;
+		unsigned HOST_WIDE_INT hval = eval_hashfn(desc, chain[i].str, strlen(chain[i].str), 0);
+		manifest_record(desc, hval, chain[i].str, strlen(chain[i].str), gimple_location(chain[i].call));
+		tree value = build_int_cstu(unsigned_type_node, hval);
+		labels.safe_push(build_case_label(value, NULL_TREE, gimple_block_label(bb)));
+		if (0 != i) {
+			make_edge(head, bb, 0);
+		}
+	}
+	sort_case_labels(labels);
+	make_edge(head, dflt, 0);
+
+	tree var = create_tmp_var(unsigned_type_node, "strhash");
+	gcall * call = gimple_build_call(fndecl, 1, unshare_expr(chain[0].subj));
+	gimple_call_set_lhs(call, var);
+	gimple_call_set_nothrow(call, true);
+	gimple_set_location(call, locus);
+	tree dflt_label = build_case_label(NULL_TREE, NULL_TREE, gimple_block_label(dflt));
+	gswitch * sw = gimple_build_switch(var, dflt_label, labels);
+	gimple_set_location(sw, locus);
+
+	gsi = gsi_last_bb(head);
+	gsi_insert_after(&gsi, call, GSI_NEW_STMT);
+	gsi_insert_after(&gsi, sw, GSI_NEW_STMT);
+
+	if (enable_call_replacement_warning) {
+		warning_at(locus, 0, "Replacing chain of %u %<strcmp%> calls with %<%s%> switch", n, desc->name);
+	}
+	report(false, first_call, "chain of %u strcmp calls rewritten to a %s switch", n, desc->name);
+	++stats.strcmp_chains;
+	stats.strcmp_cases += n;
+	return true;
+}
+
+static bool strhash_switch_pass_gate(void *, function * fn) {
+	return enable_strcmp_switch;
+}
+
+static unsigned int strhash_switch_pass_execute(void *, function * fn) {
+	long start = stats_timer_start();
+	dump_before(fn);
+	auto_vec<struct strcmp_link> links;
+	auto_vec<unsigned int> lengths;
+	bitmap visited = BITMAP_ALLOC(NULL);
+	basic_block bb;
+
+	/* find all chains first, rewriting splits blocks. */
+	FOR_EACH_BB_FN(bb, fn) {
+		if (bitmap_bit_p(visited, bb->index)) continue;
+		unsigned int n = collect_strcmp_chain(bb, visited, &links);
+		if (n < STRCMP_SWITCH_MIN_CASES) {
+			links.truncate(links.length() - n);
+		}
+		else {
+			lengths.safe_push(n);
+		}
+	}
+	BITMAP_FREE(visited);
+
+	bool changed = false;
+	for (unsigned int i = 0, first = 0; i < lengths.length(); first += lengths[i++]) {
+		changed |= rewrite_strcmp_chain(&links[first], lengths[i]);
+	}
+
+	stats_timer_stop(start);
+	if (!changed) {
+		return 0;
+	}
+
+	free_dominance_info(CDI_DOMINATORS);
+	free_dominance_info(CDI_POST_DOMINATORS);
+	if (current_loops) {
+		loops_state_set(LOOPS_NEED_FIXUP);
+	}
+	return TODO_cleanup_cfg;
 }
 
+static struct pass_data strhash_switch_pass_data = {
+	.type = GIMPLE_PASS,
+	.name = "strhash_switch",
+	.optinfo_flags = OPTGROUP_OTHER,
+	.tv_id = TV_PLUGIN_RUN,
+	.properties_required = PROP_cfg,
+	.properties_provided = 0,
+	.properties_destroyed = 0,
+	.todo_flags_start = 0,
+	.todo_flags_finish = 0,
+};
+
+DECLARE_GIMPLE_PASS(strhash_switch_pass, strhash_switch_pass_data, strhash_switch_pass_gate, strhash_switch_pass_execute);
+
 
 /*****************************************************************************
- * gimple hashing calls replacement pass
+ * runtime profile pass
+ *
+ * With the profile option every hash call left after the last folding
+ * pass is surrounded by calls of strhash-profile.c, which count calls,
+ * cycles and key lengths per call site and per thread and report them at
+ * exit, see strhash-profile.h. Each site gets a static unsigned int the
+ * runtime numbers it in, and its location and function as a literal. The
+ * pass runs after "optimized", so calls folded or inlined by any earlier
+ * pass are not counted. The program must link strhash-profile.c.
  ****************************************************************************/
 
-static const char * addr_string_cst(gimple * stmt, int i) {
-	tree expr = gimple_call_arg(stmt, i);
-	if (ADDR_EXPR == TREE_CODE(expr)) {
-		tree arg = TREE_OPERAND(expr, 0);
-		if (STRING_CST == TREE_CODE(arg)) {
-			return TREE_STRING_POINTER(arg);
-		}
+static tree profile_start_decl(void) {
+	static tree decl = NULL_TREE;
+	if (!decl) {
+		decl = build_fn_decl("strhash_profile_start", build_function_type_list(uint64_type_node, NULL_TREE));
+		SET_DECL_ASSEMBLER_NAME(decl, get_identifier("strhash_profile_start"));
+		TREE_NOTHROW(decl) = 1;
+		vec_safe_push(hashfn_decl_roots, decl);
 	}
-	return NULL;
+	return decl;
 }
 
-static struct gimple * build_unsigned_assign(tree lhs, unsigned int x) {
-	tree rhs = build_int_cst(unsigned_type_node, x);
-	gassign * assign = gimple_build_assign(lhs, rhs);
-	return (assign);
+static tree profile_stop_decl(void) {
+	static tree decl = NULL_TREE;
+	if (!decl) {
+		tree type = build_function_type_list(void_type_node,
+			build_pointer_type(unsigned_type_node),
+			build_pointer_type(build_qualified_type(char_type_node, TYPE_QUAL_CONST)),
+			const_ptr_type_node,
+			size_type_node,
+			uint64_type_node,
+			NULL_TREE);
+		decl = build_fn_decl("strhash_profile_stop", type);
+		SET_DECL_ASSEMBLER_NAME(decl, get_identifier("strhash_profile_stop"));
+		TREE_NOTHROW(decl) = 1;
+		vec_safe_push(hashfn_decl_roots, decl);
+	}
+	return decl;
 }
 
-static bool strhash_pass_gate(void *, function * fn) {
-	return true;
+/* a zeroed static unsigned int numbering the call site at runtime */
+static tree profile_site_var(location_t locus) {
+	tree var = build_decl(locus, VAR_DECL, create_tmp_var_name("strhash_site"), unsigned_type_node);
+	TREE_STATIC(var) = 1;
+	TREE_USED(var) = 1;
+	TREE_ADDRESSABLE(var) = 1;
+	DECL_ARTIFICIAL(var) = 1;
+	DECL_IGNORED_P(var) = 1;
+	DECL_INITIAL(var) = build_zero_cst(unsigned_type_node);
+	varpool_node::add(var);
+	return var;
 }
 
-static unsigned int strhash_pass_execute(void *, function * fn) {
-	gimple_seq gimple_body = fn->gimple_body;
-	//print_gimple_seq(stderr, gimple_body, 0, 0);
-
-	gimple_stmt_iterator gsi;
-	for (gsi = gsi_start(gimple_body); !gsi_end_p(gsi); gsi_next(&gsi)) {
-		gimple * stmt = gsi_stmt(gsi);
-		location_t locus = gimple_location(stmt);
-
-		/* check for function call. */
-		if (!is_gimple_call(stmt)) continue;
-
-		/* retrive function name and lookup its implementation. */
-		tree fndecl = gimple_call_fndecl(stmt);
-		const char * fname = get_name(fndecl);
-		unsigned int (* hashfn)(const char *) = lookup_hashfn(fname);
-		if (!hashfn) continue;
-
-		/* check the function has exactly one argument. */
-		if (1 != gimple_call_num_args(stmt)) {
-			if (enable_mismatch_args_warning) {
-				warning_at(locus, 0, "Hash function %qs called with multiple arguments.", fname);
-				inform(locus, "Folding to integer constant will NOT be performed.");
-			}
-			continue;
+/* instruments the hash call stmt of desc, returns false if it can not. */
+static bool profile_hashfn_call(gimple * stmt, const struct hashfn_desc * desc) {
+	basic_block bb = gimple_bb(stmt);
+	edge next = NULL;
+
+	/* a call which may throw ends its block, stop on the normal edge. */
+	if (stmt_ends_bb_p(stmt)) {
+		next = find_fallthru_edge(bb->succs);
+		if (!next || (next->flags & EDGE_ABNORMAL)) {
+			report(true, stmt, "%s call not profiled: no normal successor", desc->name);
+			return false;
 		}
+	}
 
-		/* retrive argument expression. */
-		const char * str = addr_string_cst(stmt, 0);
-		if (!str) {
-			if (enable_non_literal_arg_warning) {
-				warning_at(locus, 0, "Hash function %qs called with non literal string argument.", fname);
-				inform(locus, "Folding to integer constant will NOT be performed.");
+	location_t locus = gimple_location(stmt);
+	expanded_location xloc = expand_location(locus);
+	char name[512];
+	snprintf(name, sizeof(name), "%s:%d: %s", xloc.file ? xloc.file : "<unknown>", xloc.line, desc->name);
+
+	const unsigned int sarg = hashfn_string_arg(desc);
+	tree key = unshare_expr(gimple_call_arg(stmt, sarg));
+	tree len = hashfn_takes_length(desc) ?
+		unshare_expr(gimple_call_arg(stmt, sarg + 1)) : TYPE_MAX_VALUE(size_type_node);
+
+	gcall * start = gimple_build_call(profile_start_decl(), 0);
+	tree t = make_ssa_name(uint64_type_node, start);
+	gimple_call_set_lhs(start, t);
+	gimple_set_location(start, locus);
+
+	gcall * stop = gimple_build_call(profile_stop_decl(), 5,
+		build_fold_addr_expr(profile_site_var(locus)), build_string_literal(strlen(name) + 1, name),
+		key, fold_convert(size_type_node, len), t);
+	gimple_set_location(stop, locus);
+
+	gimple_stmt_iterator gsi = gsi_for_stmt(stmt);
+	gsi_insert_before(&gsi, start, GSI_SAME_STMT);
+	if (next) {
+		gsi_insert_on_edge_immediate(next, stop);
+	}
+	else {
+		gsi_insert_after(&gsi, stop, GSI_SAME_STMT);
+	}
+	report(false, stmt, "%s call profiled", desc->name);
+	++stats.calls_profiled;
+	return true;
+}
+
+static bool strhash_profile_pass_gate(void *, function * fn) {
+	if (!enable_profile) {
+		return false;
+	}
+	if (in_lto_p) {
+		track_symtab_hashfn_decls();
+	}
+	return hashfn_decls_used();
+}
+
+static unsigned int strhash_profile_pass_execute(void *, function * fn) {
+	long start = stats_timer_start();
+	auto_vec<gimple *> calls;
+	auto_vec<const struct hashfn_desc *> descs;
+	basic_block bb;
+
+	dump_before(fn);
+
+	/* collect the calls first, instrumenting splits edges. */
+	FOR_EACH_BB_FN(bb, fn) {
+		for (gimple_stmt_iterator gsi = gsi_start_bb(bb); !gsi_end_p(gsi); gsi_next(&gsi)) {
+			gimple * stmt = gsi_stmt(gsi);
+			tree fndecl = is_gimple_call(stmt) ? gimple_call_fndecl(stmt) : NULL_TREE;
+			const struct hashfn_desc * desc = fndecl ? lookup_hashfn_decl(fndecl) : NULL;
+			if (desc && hashfn_takes_string(desc) && HASHFN_TABLE_INDEX != desc->kind &&
+				hashfn_nargs(desc) == gimple_call_num_args(stmt)) {
+				calls.safe_push(stmt);
+				descs.safe_push(desc);
 			}
-			continue;
 		}
+	}
 
-		/* here we are replacing the function call with constant assignment. */
-		unsigned int hval = hashfn(str);
-		if (enable_call_replacement_warning) {
-			warning_at(locus, 0, "Replacing %<%s(\"%s\")%> with %qu", fname, str, hval);
-		}
-		tree lhs = gimple_call_lhs(stmt);
-		gimple * newstmt = build_unsigned_assign(lhs, hval);
-		gsi_replace(&gsi, newstmt, false);
+	bool changed = false;
+	for (unsigned int i = 0; i < calls.length(); ++i) {
+		changed |= profile_hashfn_call(calls[i], descs[i]);
 	}
 
-	return 0;
+	stats_timer_stop(start);
+	if (!changed) {
+		return 0;
+	}
+
+	/* the new calls touch memory and may have split edges. */
+	mark_virtual_operands_for_renaming(fn);
+	free_dominance_info(CDI_DOMINATORS);
+	return TODO_update_ssa_only_virtuals;
 }
 
-static struct pass_data strhash_pass_data = {
+static struct pass_data strhash_profile_pass_data = {
 	.type = GIMPLE_PASS,
-	.name = "strhash_pass",
-	.optinfo_flags = OPTGROUP_NONE,
-	.tv_id = TV_NONE,
-	.properties_required = PROP_gimple_any,
+	.name = "strhash_profile",
+	.optinfo_flags = OPTGROUP_OTHER,
+	.tv_id = TV_PLUGIN_RUN,
+	.properties_required = PROP_cfg | PROP_ssa,
 	.properties_provided = 0,
 	.properties_destroyed = 0,
 	.todo_flags_start = 0,
 	.todo_flags_finish = 0,
 };
 
-DECLARE_GIMPLE_PASS(strhash_pass, strhash_pass_data, strhash_pass_gate, strhash_pass_execute);
+DECLARE_GIMPLE_PASS(strhash_profile_pass, strhash_profile_pass_data, strhash_profile_pass_gate, strhash_profile_pass_execute);
 
 
 /*****************************************************************************
@@ -227,6 +2457,88 @@ static bool parse_args(int argc, struct plugin_argument * argv) {
 		if (strcmp(key, "no-call-replacement-warning") == 0) {
 			enable_call_replacement_warning = false;
 		}
+		else
+		if (strcmp(key, "strcmp-switch") == 0) {
+			enable_strcmp_switch = true;
+		}
+		else
+		if (strcmp(key, "no-strcmp-switch") == 0) {
+			enable_strcmp_switch = false;
+		}
+		else
+		if (strcmp(key, "manifest") == 0) {
+			if (!argv[i].value || !*argv[i].value) {
+				error("option %<-fplugin-arg-%s-%s%> requires a file name", plugin_name, key);
+				return false;
+			}
+			manifest_path = argv[i].value;
+		}
+		else
+		if (strcmp(key, "stats") == 0) {
+			if (!argv[i].value || !*argv[i].value) {
+				error("option %<-fplugin-arg-%s-%s%> requires a file name", plugin_name, key);
+				return false;
+			}
+			stats_path = argv[i].value;
+		}
+		else
+		if (strcmp(key, "seed") == 0) {
+			char * end = NULL;
+			unsigned long long v = argv[i].value ? strtoull(argv[i].value, &end, 0) : 0;
+			if (!argv[i].value || !*argv[i].value || *end || v > 0xffffffffULL) {
+				error("option %<-fplugin-arg-%s-%s%> requires a 32-bit unsigned integer", plugin_name, key);
+				return false;
+			}
+			seed_value = (uint32_t)v;
+			seed_given = true;
+		}
+		else
+		if (strcmp(key, "inline") == 0) {
+			char * end = NULL;
+			unsigned long v = argv[i].value ? strtoul(argv[i].value, &end, 0) : STRHASH_INLINE_DEFAULT;
+			if ((argv[i].value && (!*argv[i].value || *end)) || v > STRHASH_INLINE_MAX) {
+				error("option %<-fplugin-arg-%s-%s%> requires a byte count up to %d", plugin_name, key, STRHASH_INLINE_MAX);
+				return false;
+			}
+			inline_limit = (unsigned int)v;
+		}
+		else
+		if (strcmp(key, "profile") == 0) {
+			enable_profile = true;
+		}
+		else
+		if (strcmp(key, "no-profile") == 0) {
+			enable_profile = false;
+		}
+		else
+		if (strcmp(key, "literals") == 0) {
+			const char * v = argv[i].value ? argv[i].value : "";
+			if (strcmp(v, "drop") == 0) {
+				literals_mode = LITERALS_DROP;
+			}
+			else
+			if (strcmp(v, "keep") == 0) {
+				literals_mode = LITERALS_KEEP;
+			}
+			else
+			if (strcmp(v, "section") == 0) {
+				literals_mode = LITERALS_SECTION;
+			}
+			else {
+				error("option %<-fplugin-arg-%s-%s%> requires drop, keep or section", plugin_name, key);
+				return false;
+			}
+		}
+		else
+		if (strcmp(key, "lib") == 0) {
+			if (!argv[i].value || !*argv[i].value) {
+				error("option %<-fplugin-arg-%s-%s%> requires a file name", plugin_name, key);
+				return false;
+			}
+			if (!load_hashfn_lib(argv[i].value)) {
+				return false;
+			}
+		}
 		else {
 			error("unknown option %<-fplugin-arg-%s-%s%>", plugin_name, key);
 			return false;
@@ -263,7 +2575,42 @@ GCC_API int plugin_init(struct plugin_name_args * plugin_info, struct plugin_gcc
 	};
 	register_callback(plugin_name, PLUGIN_INFO, NULL, &strhash_info);
 
-	/* register my pass */
+	/* track declarations of hash functions. */
+	register_callback(plugin_name, PLUGIN_REGISTER_GGC_ROOTS, NULL, (void *)strhash_ggc_roots);
+	register_callback(plugin_name, PLUGIN_FINISH_DECL, strhash_finish_decl, NULL);
+
+	/* fold __builtin_strhash_ calls in the front end. */
+	register_callback(plugin_name, PLUGIN_PRAGMAS, strhash_register_builtins, NULL);
+
+	/* the strhash and strhash_table attributes */
+	register_callback(plugin_name, PLUGIN_ATTRIBUTES, strhash_register_attributes, NULL);
+
+	/* build perfect hash tables of strhash_table arrays. */
+	register_callback(plugin_name, PLUGIN_REGISTER_GGC_ROOTS, NULL, (void *)strhash_table_ggc_roots);
+	register_callback(plugin_name, PLUGIN_FINISH_DECL, strhash_table_finish_decl, NULL);
+#if BUILDING_GCC_VERSION >= 6000
+	/* definitions without a prior prototype never reach PLUGIN_FINISH_DECL. */
+	register_callback(plugin_name, PLUGIN_START_PARSE_FUNCTION, strhash_finish_decl, NULL);
+#endif
+
+	/* drop read-only arrays only folded hash calls used. */
+	if (LITERALS_KEEP != literals_mode) {
+		register_callback(plugin_name, PLUGIN_REGISTER_GGC_ROOTS, NULL, (void *)literal_decls_ggc_roots);
+		register_callback(plugin_name, PLUGIN_ALL_IPA_PASSES_END, drop_literal_decls, NULL);
+	}
+	if (LITERALS_SECTION == literals_mode) {
+		register_callback(plugin_name, PLUGIN_FINISH_UNIT, emit_literals_section, NULL);
+	}
+
+	/* append folded calls to the manifest. */
+	if (manifest_path) {
+		register_callback(plugin_name, PLUGIN_FINISH, manifest_flush, NULL);
+	}
+	if (stats_path) {
+		register_callback(plugin_name, PLUGIN_FINISH, stats_flush, NULL);
+	}
+
+	/* register my passes */
 	static struct register_pass_info pass_info = {
 		.pass = create_gimple_pass(strhash_pass, g, NULL),
 		.reference_pass_name = "cfg",
@@ -272,6 +2619,32 @@ GCC_API int plugin_init(struct plugin_name_args * plugin_info, struct plugin_gcc
 	};
 	register_callback(plugin_name, PLUGIN_PASS_MANAGER_SETUP, NULL, &pass_info);
 
+	/* instance number 0 means after every instance of ccp */
+	static struct register_pass_info ssa_pass_info = {
+		.pass = create_gimple_pass(strhash_ssa_pass, g, NULL),
+		.reference_pass_name = "ccp",
+		.ref_pass_instance_number = 0,
+		.pos_op = PASS_POS_INSERT_AFTER,
+	};
+	register_callback(plugin_name, PLUGIN_PASS_MANAGER_SETUP, NULL, &ssa_pass_info);
+
+	static struct register_pass_info switch_pass_info = {
+		.pass = create_gimple_pass(strhash_switch_pass, g, NULL),
+		.reference_pass_name = "cfg",
+		.ref_pass_instance_number = 1,
+		.pos_op = PASS_POS_INSERT_AFTER,
+	};
+	register_callback(plugin_name, PLUGIN_PASS_MANAGER_SETUP, NULL, &switch_pass_info);
+
+	/* the calls still there when optimization is done */
+	static struct register_pass_info profile_pass_info = {
+		.pass = create_gimple_pass(strhash_profile_pass, g, NULL),
+		.reference_pass_name = "optimized",
+		.ref_pass_instance_number = 1,
+		.pos_op = PASS_POS_INSERT_AFTER,
+	};
+	register_callback(plugin_name, PLUGIN_PASS_MANAGER_SETUP, NULL, &profile_pass_info);
+
 	return 0;
 }
 
@@ -23,24 +23,76 @@
 #include <assert.h>
 
 #include "hashfns.h"
+#include "strhash-mph.h"
+#include "strhash-intern.h"
 
 
 /****************************************************************************
- * hash function wrappers will never be replaced by integer constant
+ * hash function wrappers will never be replaced by integer constant, noipa
+ * keeps the literals out of them at -O2 and under LTO as well
  ***************************************************************************/
 
-static unsigned int noop_hash(const char * s) {
+/* static, so it is folded as the plugin's noop_hash only when marked */
+static __attribute__((strhash("noop_hash"))) unsigned int noop_hash(const char * s) {
 	return 666;
 }
 
-static unsigned int runtime_noop_hash(const char * s) {
+static __attribute__((noipa)) unsigned int runtime_noop_hash(const char * s) {
 	return noop_hash(s);
 }
 
-static unsigned int runtime_pjw_hash(const char * s) {
+static __attribute__((noipa)) unsigned int runtime_pjw_hash(const char * s) {
 	return pjw_hash(s);
 }
 
+static __attribute__((noipa)) unsigned int runtime_djb2_hash(const char * s) {
+	return djb2_hash(s);
+}
+
+static __attribute__((noipa)) unsigned int runtime_fnv1_hash(const char * s) {
+	return fnv1_hash(s);
+}
+
+static __attribute__((noipa)) unsigned int runtime_fnv1a_hash(const char * s) {
+	return fnv1a_hash(s);
+}
+
+static __attribute__((noipa)) unsigned int runtime_fnv1a_hash_n(const void * p, size_t len) {
+	return fnv1a_hash_n(p, len);
+}
+
+static __attribute__((noipa)) unsigned int runtime_crc32c_hash_n(const void * p, size_t len) {
+	return crc32c_hash_n(p, len);
+}
+
+static __attribute__((noipa)) unsigned int runtime_murmur3_hash_seeded(const char * s, uint32_t seed) {
+	return murmur3_hash_seeded(s, seed);
+}
+
+static __attribute__((noipa)) uint64_t runtime_fnv1a_hash64(const char * s) {
+	return fnv1a_hash64(s);
+}
+
+
+static const char * const keywords[] STRHASH_TABLE(fnv1a_hash) = {
+	"if", "else", "while", "for", NULL, "return", "if",
+};
+
+#define NKEYWORDS (sizeof(keywords) / sizeof(keywords[0]))
+
+
+/* folded by the front end where C requires an integer constant */
+static const unsigned int qwerty_hash = STRHASH_CONST(fnv1a_hash, "qwerty");
+_Static_assert(STRHASH_CONST(fnv1a_hash, "qwerty") == 0x1ae54459U, "fnv1a_hash(\"qwerty\")");
+
+static int keyword_class(const char * s) {
+	switch (fnv1a_hash(s)) {
+		case STRHASH_CONST(fnv1a_hash, "if"): return 1;
+		case STRHASH_CONST(fnv1a_hash_n, "else", 4): return 2;
+		default: return 0;
+	}
+}
+
 
 /****************************************************************************
  * tests
@@ -52,6 +104,9 @@ static unsigned int runtime_pjw_hash(const char * s) {
 #define RUNTIME_HASH(hashfn, x) CONCAT(runtime_, hashfn)(x)
 #define STATIC_HASH(hashfn, x) hashfn(x)
 
+#define Q10 "qqqqqqqqqq"
+#define Q100 Q10 Q10 Q10 Q10 Q10 Q10 Q10 Q10 Q10 Q10
+
 #define expect(expr) \
 	do { \
 		const char * msg = STRINGIFY(expr); \
@@ -73,6 +128,119 @@ int main(int argc, char **argv) {
 	const char * s = argv[0];
 	expect(STATIC_HASH(pjw_hash, s) == RUNTIME_HASH(pjw_hash, s));
 
+	/* read-only arrays are constant strings as well */
+	static const char hello[] = "hello";
+	expect(STATIC_HASH(noop_hash, hello) == 0xdeadbeef);
+	expect(STATIC_HASH(noop_hash, __func__) == 0xdeadbeef);
+
+	/* length-aware variants are folded for constant length, NULs included */
+	expect(fnv1a_hash_n("qwerty", 6) == RUNTIME_HASH(fnv1a_hash, "qwerty"));
+	expect(fnv1a_hash_n("qwe\0rty", 7) == runtime_fnv1a_hash_n("qwe\0rty", 7));
+	expect(fnv1a_hash_n(s, strlen(s)) == RUNTIME_HASH(fnv1a_hash, s));
+
+	/* 64-bit hashes are folded to 64-bit constants */
+	expect(STATIC_HASH(fnv1a_hash64, "qwerty") == RUNTIME_HASH(fnv1a_hash64, "qwerty"));
+	expect(STATIC_HASH(fnv1a_hash64, "qwerty") == 0x3eb459c7c3501ff9ULL);
+
+	/* block hashes are folded to the reference values */
+	expect(STATIC_HASH(xxh32_hash, "abc") == 0x32d153ffU);
+	expect(STATIC_HASH(xxh64_hash, "abc") == 0x44bc2cf5ad770999ULL);
+	expect(STATIC_HASH(murmur3_hash, "hello") == 0x248bfa47U);
+	expect(STATIC_HASH(wy_hash, "") == 0x93228a4de0eec5a2ULL);
+
+	/* CRC-32C folds with the portable code, runtime may use SSE4.2 */
+	expect(STATIC_HASH(crc32c_hash, "123456789") == 0xe3069283U);
+	{
+		static char buf[1000];
+		memset(buf, 'q', sizeof(buf));
+		expect(crc32c_hash_n(Q100 Q100 Q100 Q100, 400)
+			== runtime_crc32c_hash_n(buf, 400));
+	}
+
+	/* seeded hashes fold for constant seeds, strhash_seed() is seed= */
+	expect(murmur3_hash_seeded("Hello, world!", 1234) == 0xfaf6cdb3U);
+	expect(murmur3_hash_seeded("qwerty", 1234) == runtime_murmur3_hash_seeded("qwerty", 1234));
+	expect(strhash_seed() == 0x5eed);
+	expect(xxh32_hash_seeded("abc", strhash_seed()) != xxh32_hash("abc"));
+
+	/* streaming: a literal prefix folds to a state, the suffix is hashed */
+	{
+		char rty[] = "rty";
+		expect(fnv1a_final(fnv1a_update(fnv1a_init(), "qwerty", 6)) == 0x1ae54459U);
+		expect(fnv1a_final(fnv1a_update(fnv1a_update(fnv1a_init(), "qwe", 3), rty, 3))
+			== RUNTIME_HASH(fnv1a_hash, "qwerty"));
+	}
+
+	/* perfect hash tables find the first position like a scan */
+	{
+		char ret[] = "return";
+		expect(strhash_table_index(keywords, NKEYWORDS, "while") == 2);
+		expect(strhash_table_index(keywords, NKEYWORDS, "if") == 0);
+		expect(strhash_table_index(keywords, NKEYWORDS, ret) == 5);
+		expect(strhash_table_index(keywords, NKEYWORDS, s) == -1);
+	}
+
+	/* front end constants match the runtime */
+	expect(qwerty_hash == RUNTIME_HASH(fnv1a_hash, "qwerty"));
+	expect(keyword_class("else") == 2 && keyword_class("for") == 0);
+
+	/* inline expansion of short keys matches the library */
+	{
+		struct { char key[16]; int n; } rec;
+		char buf[] = "qwerty";
+		size_t n = strlen(buf);
+		memset(&rec, 0, sizeof(rec));
+		strcpy(rec.key, buf);
+		expect(fnv1a_hash(rec.key) == RUNTIME_HASH(fnv1a_hash, "qwerty"));
+		expect(djb2_hash_n(buf, 4) == RUNTIME_HASH(djb2_hash, "qwer"));
+		expect(n == 6 && fnv1_hash(buf) == RUNTIME_HASH(fnv1_hash, "qwerty"));
+	}
+
+	/* batch hashing matches hashing the keys one by one */
+	{
+		static char buf[300];
+		const char * keys[200];
+		size_t lens[200];
+		uint32_t out[200];
+		bool same = true;
+		size_t i;
+
+		memset(buf, 'x', sizeof(buf));
+		for (i = 0; i < 200; ++i) {
+			keys[i] = buf + i % 7;
+			lens[i] = (i * 37) % 290;
+			buf[i] = (char)i;
+		}
+		fnv1a_hash_many(keys, lens, 200, out);
+		for (i = 0; i < 200; ++i) {
+			same = same && out[i] == runtime_fnv1a_hash_n(keys[i], lens[i]);
+		}
+		expect(same);
+	}
+
+	/* interning: one copy per key, folded literal hashes find it too */
+	{
+		char buf[] = "while";
+		struct strhash_intern * tab = strhash_intern_new(fnv1a_hash_n, 0);
+		const char * w = strhash_intern(tab, buf, 5);
+		const char * z = strhash_intern(tab, "a\0b", 3);
+		bool same = true;
+		size_t i;
+
+		for (i = 0; i < 5000; ++i) {
+			char key[16];
+			snprintf(key, sizeof(key), "k%zu", i);
+			same = same && strhash_intern(tab, key, strlen(key)) != NULL;
+		}
+		expect(w != buf && strcmp(w, "while") == 0 && strhash_intern_len(w) == 5);
+		expect(STRHASH_INTERN_FIND(tab, fnv1a_hash, "while") == w);
+		expect(STRHASH_INTERN(tab, fnv1a_hash, "a\0b") == z && strhash_intern_len(z) == 3);
+		expect(strhash_intern_find(tab, "a", 1) == NULL);
+		expect(same && strhash_intern_find(tab, "k4321", 5) != NULL);
+		expect(strhash_intern_count(tab) == 5002);
+		strhash_intern_free(tab);
+	}
+
 	return EXIT_SUCCESS;
 }
 